@@ -15,17 +15,19 @@
  * http://www.perlfoundation.org/artistic_license_2_0.
  */
 
+#include <dirent.h>
+#if defined(__linux__)
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
 #include <synthpod_app_private.h>
 #include <synthpod_patcher.h>
 
 #include <osc.lv2/util.h>
 #include <osc.lv2/forge.h>
 
-#if defined(__NetBSD__) || defined(__FreeBSD__) || defined(__DragonFly__) || defined(__OpenBSD__)
-#	include <pthread_np.h>
-typedef cpuset_t cpu_set_t;
-#endif
-
 #define REWEIGHT_S 4
 
 // non-rt
@@ -185,6 +187,21 @@ _sp_app_find_automation_for_property(mod_t *mod, LV2_URID property)
 	return NULL;
 }
 
+__realtime static inline LV2_Atom_Forge_Ref
+_sp_app_automation_out_cc(sp_app_t *app, LV2_Atom_Forge *forge, uint32_t frames,
+	uint8_t channel, uint8_t controller, uint8_t value)
+{
+	const uint8_t msg [3] = {0xb0 | channel, controller, value};
+
+	LV2_Atom_Forge_Ref ref = lv2_atom_forge_frame_time(forge, frames);
+	if(ref)
+		ref = lv2_atom_forge_atom(forge, 3, app->regs.port.midi.urid);
+	if(ref)
+		ref = lv2_atom_forge_write(forge, msg, 3);
+
+	return ref;
+}
+
 __realtime static inline LV2_Atom_Forge_Ref
 _sp_app_automation_out(sp_app_t *app, LV2_Atom_Forge *forge, auto_t *automation, uint32_t frames, double value)
 {
@@ -197,16 +214,39 @@ _sp_app_automation_out(sp_app_t *app, LV2_Atom_Forge *forge, auto_t *automation,
 		const uint8_t channel = (mauto->channel >= 0)
 			? mauto->channel
 			: 0;
-		const uint8_t controller = (mauto->controller >= 0)
+		const uint16_t controller = (mauto->controller >= 0)
 			? mauto->controller
 			: 0;
-		const uint8_t msg [3] = {0xb0 | channel, controller, round(value)};
+		const uint16_t val = round(value);
 
-		ref = lv2_atom_forge_frame_time(forge, frames);
-		if(ref)
-			ref = lv2_atom_forge_atom(forge, 3, app->regs.port.midi.urid);
-		if(ref)
-			ref = lv2_atom_forge_write(forge, msg, 3);
+		switch(mauto->mode)
+		{
+			case AUTO_MIDI_MODE_CC7:
+			{
+				ref = _sp_app_automation_out_cc(app, forge, frames, channel,
+					controller & 0x7f, val & 0x7f);
+			} break;
+			case AUTO_MIDI_MODE_CC14:
+			{
+				ref = _sp_app_automation_out_cc(app, forge, frames, channel,
+						controller & 0x1f, (val >> 7) & 0x7f)
+					&& _sp_app_automation_out_cc(app, forge, frames, channel,
+						(controller & 0x1f) | 0x20, val & 0x7f);
+			} break;
+			case AUTO_MIDI_MODE_NRPN:
+			{
+				ref = _sp_app_automation_out_cc(app, forge, frames, channel,
+						0x63, (controller >> 7) & 0x7f)
+					&& _sp_app_automation_out_cc(app, forge, frames, channel,
+						0x62, controller & 0x7f)
+					&& _sp_app_automation_out_cc(app, forge, frames, channel,
+						0x06, (val >> 7) & 0x7f)
+					&& _sp_app_automation_out_cc(app, forge, frames, channel,
+						0x26, val & 0x7f);
+			} break;
+			case AUTO_MIDI_MODE_NUM:
+				break;
+		}
 	}
 	else if(automation->type == AUTO_TYPE_OSC)
 	{
@@ -220,6 +260,413 @@ _sp_app_automation_out(sp_app_t *app, LV2_Atom_Forge *forge, auto_t *automation,
 	return ref;
 }
 
+// queue automation output, coalesced until next feedback flush
+__realtime static inline void
+_sp_app_automation_feedback(mod_t *mod, auto_t *automation, double value)
+{
+	automation->feedback_value = value;
+	mod->auto_feedback |= UINT64_C(1) << (automation - mod->automations);
+}
+
+// send pending automation output, OSC messages go into a single bundle
+__realtime static inline LV2_Atom_Forge_Ref
+_sp_app_automation_flush(sp_app_t *app, LV2_Atom_Forge *forge, mod_t *mod)
+{
+	LV2_Atom_Forge_Ref ref = 1;
+	unsigned num_osc = 0;
+
+	uint64_t slots = mod->auto_feedback;
+	while(slots && ref)
+	{
+		const unsigned i = __builtin_ctzll(slots);
+		auto_t *automation = &mod->automations[i];
+
+		slots &= slots - 1; // clear lowest set bit
+
+		if(automation->type == AUTO_TYPE_OSC)
+			num_osc += 1;
+		else if(automation->type == AUTO_TYPE_MIDI)
+			ref = _sp_app_automation_out(app, forge, automation, 0, automation->feedback_value);
+	}
+
+	if(ref && num_osc)
+	{
+		const LV2_OSC_Timetag immediate = {.integral = 0, .fraction = 1};
+		LV2_Atom_Forge_Frame bndl_frame [2];
+
+		ref = lv2_atom_forge_frame_time(forge, 0)
+			&& lv2_osc_forge_bundle_head(forge, &app->osc_urid, bndl_frame, &immediate);
+
+		slots = mod->auto_feedback;
+		while(slots && ref)
+		{
+			const unsigned i = __builtin_ctzll(slots);
+			auto_t *automation = &mod->automations[i];
+
+			slots &= slots - 1; // clear lowest set bit
+
+			if(automation->type == AUTO_TYPE_OSC)
+			{
+				ref = lv2_osc_forge_message_vararg(forge, &app->osc_urid,
+					automation->osc.path, "d", automation->feedback_value); //FIXME what type should be used?
+			}
+		}
+
+		if(ref)
+			lv2_osc_forge_pop(forge, bndl_frame);
+	}
+
+	if(ref) // else retry with next flush, as sequence gets cleared on overflow
+		mod->auto_feedback = 0;
+
+	return ref;
+}
+
+// whether inputs carry neither signal, events nor control changes
+__realtime static inline bool
+_sp_app_mod_inputs_quiet(mod_t *mod)
+{
+	bool quiet = true;
+
+	for(unsigned p=0; p<mod->num_ports; p++)
+	{
+		port_t *port = &mod->ports[p];
+
+		if(port->direction != PORT_DIRECTION_INPUT)
+			continue;
+
+		switch(port->type)
+		{
+			case PORT_TYPE_AUDIO:
+			{
+				if(!port->audio.silent)
+					quiet = false;
+			}	break;
+			case PORT_TYPE_CV:
+			{
+				if(port->cv.connectable.num_sources)
+					quiet = false;
+			}	break;
+			case PORT_TYPE_CONTROL:
+			{
+				const float *val = PORT_BASE_ALIGNED(port);
+
+				if(*val != port->control.quiet)
+				{
+					port->control.quiet = *val;
+					quiet = false;
+				}
+			}	break;
+			case PORT_TYPE_ATOM:
+			{
+				const LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
+
+				if(  (port->atom.buffer_type != PORT_BUFFER_TYPE_SEQUENCE)
+					|| (seq->atom.size > sizeof(LV2_Atom_Sequence_Body)) )
+					quiet = false;
+			}	break;
+			case PORT_TYPE_NUM:
+				break;
+		}
+	}
+
+	return quiet;
+}
+
+// whether outputs are silent, flags silent audio output buffers
+__realtime static inline bool
+_sp_app_mod_outputs_silent(mod_t *mod, uint32_t nsamples, bool check)
+{
+	bool silent = true;
+
+	for(unsigned p=0; p<mod->num_ports - 4; p++) // ignore debug and automation ports
+	{
+		port_t *port = &mod->ports[p];
+
+		if(port->direction != PORT_DIRECTION_OUTPUT)
+			continue;
+
+		if( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) )
+		{
+			const float *val = PORT_SIGNAL_ALIGNED(port);
+			bool zero = check;
+
+			for(uint32_t j=0; zero && (j<nsamples); j++)
+			{
+				if(val[j] != 0.f)
+					zero = false;
+			}
+
+			if(port->type == PORT_TYPE_AUDIO)
+				port->audio.silent = zero;
+
+			if(!zero)
+				silent = false;
+		}
+		else if( (port->type == PORT_TYPE_ATOM)
+			&& (port->atom.buffer_type == PORT_BUFFER_TYPE_SEQUENCE) )
+		{
+			const LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
+
+			if(seq->atom.size > sizeof(LV2_Atom_Sequence_Body))
+				silent = false;
+		}
+	}
+
+	return silent;
+}
+
+// clear event outputs of a module that is not run, as well as signal outputs
+// in shared buffers, which have been overwritten by other modules
+__realtime static inline void
+_sp_app_mod_outputs_clear(mod_t *mod, uint32_t nsamples)
+{
+	for(unsigned p=0; p<mod->num_ports - 4; p++) // ignore debug and automation ports
+	{
+		port_t *port = &mod->ports[p];
+
+		if(port->direction != PORT_DIRECTION_OUTPUT)
+			continue;
+
+		if(  (port->type == PORT_TYPE_ATOM)
+			&& (port->atom.buffer_type == PORT_BUFFER_TYPE_SEQUENCE) )
+		{
+			lv2_atom_sequence_clear(PORT_BASE_ALIGNED(port));
+		}
+		else if( ( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) )
+			&& (port->base != port->priv) )
+		{
+			memset(PORT_SIGNAL_ALIGNED(port), 0x0, nsamples * sizeof(float));
+		}
+	}
+}
+
+// keep outputs for readers in later pipeline stage of next period
+__realtime void
+_sp_app_mod_outputs_delay(mod_t *mod, uint32_t nsamples)
+{
+	for(unsigned p=0; p<mod->num_ports - 4; p++) // ignore debug and automation ports
+	{
+		port_t *port = &mod->ports[p];
+
+		if(!port->delay)
+			continue; // skip
+
+		if( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) )
+		{
+			memcpy(ASSUME_CACHE_ALIGNED(port->delay), PORT_SIGNAL_ALIGNED(port),
+				nsamples * sizeof(float));
+		}
+		else if(port->type == PORT_TYPE_ATOM)
+		{
+			const LV2_Atom *atom = PORT_BASE_ALIGNED(port);
+			size_t size = lv2_atom_total_size(atom);
+
+			if(size > port->size)
+				size = port->size;
+
+			memcpy(port->delay, atom, size);
+		}
+	}
+}
+
+__realtime static inline void
+_sp_app_mod_split_apply(mod_t *mod, const split_t *split)
+{
+	port_t *port = &mod->ports[split->index];
+	float *buf = PORT_BASE_ALIGNED(port);
+
+	*buf = split->value;
+	_sp_app_port_control_stash(port);
+}
+
+__realtime static inline void
+_sp_app_mod_run_sub(sp_app_t *app, mod_t *mod, uint32_t offset, uint32_t nsamples)
+{
+	// point audio and CV ports to sub-block
+	for(unsigned i=0; i<mod->num_ports - 4; i++)
+	{
+		port_t *port = &mod->ports[i];
+
+		if( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) )
+		{
+			float *buf = PORT_BUF_ALIGNED(port);
+			lilv_instance_connect_port(mod->inst, i, &buf[offset]);
+		}
+	}
+
+	while(nsamples)
+	{
+		uint32_t len = nsamples;
+
+		if(app->split_pow2)
+		{
+			while(len & (len - 1)) // largest power of 2 not above nsamples
+				len &= len - 1;
+		}
+
+		lilv_instance_run(mod->inst, len);
+
+		nsamples -= len;
+		if(!nsamples)
+			break;
+
+		offset += len;
+		for(unsigned i=0; i<mod->num_ports - 4; i++)
+		{
+			port_t *port = &mod->ports[i];
+
+			if( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) )
+			{
+				float *buf = PORT_BUF_ALIGNED(port);
+				lilv_instance_connect_port(mod->inst, i, &buf[offset]);
+			}
+		}
+	}
+}
+
+// advance smoothed automation value by given frames
+__realtime static inline float
+_automation_smooth_advance(auto_t *automation, uint32_t frames)
+{
+	const float target = automation->smoothing_target;
+	float val = automation->smoothing_value;
+
+	if(automation->smoothing == AUTO_SMOOTHING_ONE_POLE)
+	{
+		// settle once within 0.01% of destination range
+		val = target + (val - target) * expf(-(float)frames / automation->smoothing_frames);
+		if(fabsf(val - target) <= 1e-4f * fabs(automation->d - automation->c))
+			automation->smoothing_remaining = 0;
+	}
+	else if(frames < automation->smoothing_remaining) // linear
+	{
+		val += (target - val) * frames / automation->smoothing_remaining;
+		automation->smoothing_remaining -= frames;
+	}
+	else
+	{
+		automation->smoothing_remaining = 0;
+	}
+
+	if(!automation->smoothing_remaining)
+		val = target;
+
+	automation->smoothing_value = val;
+	return val;
+}
+
+// step ramps of smoothed control automations, at sub-block boundaries in
+// split-run mode, else once per period
+__realtime static inline void
+_sp_app_mod_smooth(sp_app_t *app, mod_t *mod, uint32_t nsamples)
+{
+	const uint32_t split = (app->split_frames && mod->splittable)
+		? _sp_app_split_frames(app)
+		: nsamples;
+
+	uint64_t slots = mod->auto_smoothing;
+	while(slots)
+	{
+		const unsigned i = __builtin_ctzll(slots);
+		auto_t *automation = &mod->automations[i];
+		const uint32_t start = automation->smoothing_start;
+
+		slots &= slots - 1; // clear lowest set bit
+
+		for(uint32_t offset = 0; offset < nsamples; offset += split)
+		{
+			const uint32_t end = (nsamples - offset > split)
+				? offset + split
+				: nsamples;
+
+			if(start >= end)
+				continue; // ramp starts in later sub-block
+
+			if(offset == 0)
+			{
+				port_t *port = &mod->ports[automation->index];
+				float *buf = PORT_BASE_ALIGNED(port);
+
+				*buf = _automation_smooth_advance(automation, end - start);
+				_sp_app_port_control_stash(port);
+			}
+			else
+			{
+				split_t *sp = _sp_app_mod_split_insert(mod, offset);
+				if(!sp)
+					break; // continue next period
+
+				sp->index = automation->index;
+				sp->value = _automation_smooth_advance(automation,
+					end - (start > offset ? start : offset));
+			}
+
+			if(!automation->smoothing_remaining)
+			{
+				mod->auto_smoothing &= ~(UINT64_C(1) << i); // target reached
+				break;
+			}
+		}
+
+		automation->smoothing_start = 0;
+	}
+}
+
+// run plugin in sub-blocks split at pending control automation events
+__realtime static inline void
+_sp_app_mod_run(sp_app_t *app, mod_t *mod, uint32_t nsamples)
+{
+	if(!mod->num_splits)
+	{
+		lilv_instance_run(mod->inst, nsamples);
+		return;
+	}
+
+	const uint32_t split = _sp_app_split_frames(app);
+	const uint32_t last = nsamples >= 2*split // last boundary with full sub-block after it
+		? (nsamples - split) / split * split
+		: 0;
+	uint32_t offset = 0;
+	unsigned s = 0;
+
+	while(offset < nsamples)
+	{
+		uint32_t end = nsamples;
+
+		// apply events up to current offset, find next boundary
+		for( ; s < mod->num_splits; s++)
+		{
+			const split_t *sp = &mod->splits[s];
+			uint32_t boundary = sp->frames / split * split;
+			if(boundary > last)
+				boundary = last;
+
+			if(boundary > offset)
+			{
+				end = boundary;
+				break;
+			}
+
+			_sp_app_mod_split_apply(mod, sp);
+		}
+
+		_sp_app_mod_run_sub(app, mod, offset, end - offset);
+		offset = end;
+	}
+
+	mod->num_splits = 0;
+
+	// point audio and CV ports to whole period again
+	for(unsigned i=0; i<mod->num_ports - 4; i++)
+	{
+		port_t *port = &mod->ports[i];
+
+		if( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) )
+			lilv_instance_connect_port(mod->inst, i, PORT_BUF_ALIGNED(port));
+	}
+}
+
 __realtime static inline void
 _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 {
@@ -229,33 +676,46 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 	struct timespec mod_t2;
 	cross_clock_gettime(&app->clk_mono, &mod_t1);
 
+	// reset atom sequence outputs to full capacity
+	const unsigned *seq_outs = &mod->seq_ports[mod->num_seq_ins];
+	for(unsigned i=0; i<mod->num_seq_outs; i++)
+	{
+		port_t *port = &mod->ports[seq_outs[i]];
+
+		LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
+		seq->atom.size = port->size;
+		seq->atom.type = app->forge.Sequence;
+		seq->body.unit = 0;
+		seq->body.pad = 0;
+	}
+
 	// multiplex multiple sources to single sink where needed
 	for(int p=mod->num_ports-1; p>=0; p--)
 	{
 		port_t *port = &mod->ports[p];
 
-		if(port->direction == PORT_DIRECTION_OUTPUT)
+		if(port->direction == PORT_DIRECTION_INPUT)
 		{
-			if(  (port->type == PORT_TYPE_ATOM)
-				&& (port->atom.buffer_type == PORT_BUFFER_TYPE_SEQUENCE)
-				&& (!mod->system_ports) // don't overwrite source buffer events
-				&& (p != mod->num_ports - 4) // ignore dsp debug port
-				&& (p != mod->num_ports - 3) ) // ignore ui debug port
+			if(  mod->disabled
+				&& ( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) ) )
 			{
-				LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
-				seq->atom.size = port->size;
-				seq->atom.type = app->forge.Sequence;
-				seq->body.unit = 0;
-				seq->body.pad = 0;
+				_sp_app_port_ramps_update(app, port, nsamples); // no need to multiplex
 			}
-		}
-		else // PORT_DIRECTION_INPUT
-		{
-			if(port->driver->multiplex)
+			else if(port->driver->multiplex)
+			{
 				port->driver->multiplex(app, port, nsamples);
+			}
 		}
 	}
 
+	if(mod->auto_smoothing)
+		_sp_app_mod_smooth(app, mod, nsamples);
+
+	// silence detection
+	const bool skip_silence = app->skip_silence && mod->silence_tail;
+	bool quiet = skip_silence && !mod->system_ports && !mod->num_splits
+		&& _sp_app_mod_inputs_quiet(mod);
+
 	mod_worker_t *mod_worker = &mod->mod_worker;
 	if(mod_worker->app_from_worker)
 	{
@@ -263,6 +723,8 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 		size_t size;
 		while((payload = varchunk_read_request(mod_worker->app_from_worker, &size)))
 		{
+			quiet = false; // module has got work to do
+
 			if(mod->worker.iface && mod->worker.iface->work_response)
 			{
 				mod->worker.iface->work_response(mod->handle, size, payload);
@@ -277,12 +739,39 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 	if(!mod->bypassed)
 	{
 		// run plugin
-		if(!mod->disabled)
+		if(mod->disabled)
+		{
+			_sp_app_mod_outputs_clear(mod, nsamples); // readers may still mix them
+		}
+		else if(quiet && mod->idle)
+		{
+			_sp_app_mod_outputs_clear(mod, nsamples); // private audio outputs are still silent
+		}
+		else
 		{
-			lilv_instance_run(mod->inst, nsamples);
+			_sp_app_mod_run(app, mod, nsamples);
+
+			if(skip_silence)
+			{
+				// outputs must stay silent for tail duration before going idle
+				if(_sp_app_mod_outputs_silent(mod, nsamples, quiet) && quiet)
+					mod->quiet_samples += nsamples;
+				else
+					mod->quiet_samples = 0;
+
+				mod->idle = (mod->quiet_samples >= mod->silence_tail);
+			}
 		}
+
+		if(!quiet)
+			mod->idle = false;
 	}
 
+	// apply automation events left over by skipped plugin
+	for(unsigned s=0; s<mod->num_splits; s++)
+		_sp_app_mod_split_apply(mod, &mod->splits[s]);
+	mod->num_splits = 0;
+
 	// handle end of work
 	if(mod->worker.iface && mod->worker.iface->end_run)
 	{
@@ -304,33 +793,39 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 
 		if(_sp_app_has_source_automations(mod))
 		{
-			uint32_t t0 = 0;
+			_sp_app_mod_controls_changed(mod);
 
-			for(unsigned p=0; p<mod->num_ports; p++)
+			// iterate over control ports which have changed since last cycle
+			for(unsigned w=0; w<(mod->ctrl.num + 63) / 64; w++)
 			{
-				port_t *port = &mod->ports[p];
+				uint64_t bits = mod->ctrl.dirty[w] | mod->ctrl.auto_dirty[w];
+
+				mod->ctrl.auto_dirty[w] = 0;
 
-				if(port->type == PORT_TYPE_CONTROL)
+				while(bits)
 				{
-					const float *val = PORT_BASE_ALIGNED(port);
+					const unsigned k = w*64 + __builtin_ctzll(bits);
+					const unsigned p = mod->ctrl.ports[k];
+					const float *val = PORT_BASE_ALIGNED(&mod->ports[p]);
 
-					if(  (*val != port->control.last)
-						|| (port->control.auto_dirty) ) // has changed since last cycle
-					{
-						auto_t *automation = _sp_app_find_automation_for_port(mod, p);
+					bits &= bits - 1; // clear lowest set bit
 
-						if(automation && automation->src_enabled)
-						{
-							const double value = (*val - automation->add) / automation->mul;
+					auto_t *automation = _sp_app_find_automation_for_port(mod, p);
 
-							if(ref)
-								ref = _sp_app_automation_out(app, &forge, automation, t0, value);
-						}
+					if(automation && automation->src_enabled)
+					{
+						const double value = (*val - automation->add) / automation->mul;
 
-						port->control.auto_dirty = false;
+						_sp_app_automation_feedback(mod, automation, value);
 					}
 				}
-				else if( (port->type == PORT_TYPE_ATOM)
+			}
+
+			for(unsigned p=0; p<mod->num_ports; p++)
+			{
+				port_t *port = &mod->ports[p];
+
+				if( (port->type == PORT_TYPE_ATOM)
 					&& port->atom.patchable )
 				{
 					const LV2_Atom_Sequence *patch_seq = PORT_BASE_ALIGNED(port);
@@ -378,10 +873,7 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 
 								const double value = (val - automation->add) / automation->mul;
 
-								if(ref)
-									ref = _sp_app_automation_out(app, &forge, automation, ev->time.frames, value);
-
-								t0 = ev->time.frames;
+								_sp_app_automation_feedback(mod, automation, value);
 							}
 						}
 						else if(obj->body.otype == app->regs.patch.put.urid)
@@ -421,10 +913,7 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 
 									const double value = (val - automation->add) / automation->mul;
 
-									if(ref)
-										ref = _sp_app_automation_out(app, &forge, automation, ev->time.frames, value);
-
-									t0 = ev->time.frames;
+									_sp_app_automation_feedback(mod, automation, value);
 								}
 							}
 						}
@@ -433,6 +922,10 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 			}
 		}
 
+		// coalesced feedback is only sent at feedback rate
+		if(ref && mod->auto_feedback && app->feedback.timeout)
+			ref = _sp_app_automation_flush(app, &forge, mod);
+
 		if(ref)
 		{
 			lv2_atom_forge_pop(&forge, &frame);
@@ -446,6 +939,21 @@ _sp_app_process_single_run(mod_t *mod, uint32_t nsamples)
 		}
 	}
 
+	// parse events once for all automation inputs fed by this module
+	if(mod->routed)
+	{
+		for(unsigned p=0; p<mod->num_ports; p++)
+		{
+			port_t *port = &mod->ports[p];
+
+			if(  (port->type == PORT_TYPE_ATOM) && (port->direction == PORT_DIRECTION_OUTPUT)
+				&& port->atom.routed )
+			{
+				_sp_app_port_route(app, port, nsamples);
+			}
+		}
+	}
+
 	cross_clock_gettime(&app->clk_mono, &mod_t2);
 
 	// profiling
@@ -558,6 +1066,10 @@ _sp_app_process_single_post(mod_t *mod, uint32_t nsamples, bool sparse_update_ti
 		}
 	}
 
+	// refresh bitmap of changed control values for sparse notifications
+	if(sparse_update_timeout && mod->ctrl.num)
+		_sp_app_mod_controls_changed(mod);
+
 	// handle mod ui post
 	for(unsigned i=0; i<mod->num_ports; i++)
 	{
@@ -691,64 +1203,184 @@ _sp_app_process_single_post(mod_t *mod, uint32_t nsamples, bool sparse_update_ti
 	}
 }
 
+#define DSP_NODE_NONE -1 // no node available
+
+__realtime static inline void
+_dsp_pause(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+__realtime static inline void
+_dsp_deque_push(dsp_deque_t *deque, unsigned node)
+{
+	const int b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+
+	atomic_store_explicit(&deque->nodes[b], node, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+}
+
 __realtime static inline int
-_dsp_slave_fetch(dsp_master_t *dsp_master, int head)
+_dsp_deque_take(dsp_deque_t *deque)
 {
-	sp_app_t *app = (void *)dsp_master - offsetof(sp_app_t, dsp_master);
+	const int b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
 
-	const unsigned M = head;
-	head = -1; // assume no more work left
+	atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int t = atomic_load_explicit(&deque->top, memory_order_relaxed);
 
-	for(unsigned m=M; m<app->num_mods; m++)
+	if(t > b) // deque is empty
 	{
-		mod_t *mod = app->mods[m];
-		dsp_client_t *dsp_client = &mod->dsp_client;
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		return DSP_NODE_NONE;
+	}
 
-		int expected = 0;
-		const int desired = -1; // mark as done
-		const bool match = atomic_compare_exchange_weak(&dsp_client->ref_count,
-			&expected, desired);
-		if(match) // needs to run now
-		{
-			_sp_app_process_single_run(mod, dsp_master->nsamples);
+	int node = atomic_load_explicit(&deque->nodes[b], memory_order_relaxed);
 
-			for(unsigned j=0; j<dsp_client->num_sinks; j++)
-			{
-				dsp_client_t *sink = dsp_client->sinks[j];
-				const int32_t ref_count = atomic_fetch_sub(&sink->ref_count, 1);
-				assert(ref_count >= 0);
-			}
-		}
-		else if(expected >= 0) // needs to run later
-		{
-			if(head == -1) // only set heading position once per loop
-			{
-				head = m;
-			}
-		}
+	if(t == b) // last node, race against thieves
+	{
+		if(!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+				memory_order_seq_cst, memory_order_relaxed))
+			node = DSP_NODE_NONE; // lost race
+
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
 	}
 
-	return head;
+	return node;
+}
+
+__realtime static inline int
+_dsp_deque_steal(dsp_deque_t *deque)
+{
+	int t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	const int b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if(t >= b) // deque is empty
+		return DSP_NODE_NONE;
+
+	const int node = atomic_load_explicit(&deque->nodes[t], memory_order_relaxed);
+
+	if(!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+			memory_order_seq_cst, memory_order_relaxed))
+		return DSP_NODE_NONE; // lost race
+
+	return node;
 }
 
 __realtime static inline void
-_dsp_slave_spin(sp_app_t *app, dsp_master_t *dsp_master, bool post)
+_dsp_slave_run(dsp_master_t *dsp_master, const dsp_plan_t *plan,
+	dsp_deque_t *deque, unsigned node)
 {
-	int head = 0;
+	unsigned num_done = 1;
+
+	_sp_app_process_single_run(plan->mods[node], dsp_master->nsamples);
+
+	// run fused chain back-to-back while buffers are hot
+	for(int next = plan->chain[node]; next != -1; next = plan->chain[node])
+	{
+		node = next;
+		num_done += 1;
+
+		_sp_app_process_single_run(plan->mods[node], dsp_master->nsamples);
+	}
+
+	// release sinks, push those that are ready to run now onto local deque
+	for(unsigned j=plan->sinks_offset[node]; j<plan->sinks_offset[node+1]; j++)
+	{
+		const unsigned sink = plan->sinks[j];
+		const int ref_count = atomic_fetch_sub_explicit(&plan->ref_counts[sink], 1,
+			memory_order_acq_rel);
+		assert(ref_count > 0);
+
+		if(ref_count == 1)
+			_dsp_deque_push(deque, sink);
+	}
+
+	atomic_fetch_add_explicit(&dsp_master->num_done, num_done, memory_order_release);
+}
 
-	while(!atomic_load(&dsp_master->emergency_exit))
+__realtime static inline int
+_dsp_slave_steal(dsp_master_t *dsp_master, unsigned self)
+{
+	for(unsigned i=1; i<dsp_master->num_active; i++)
 	{
-		head = _dsp_slave_fetch(dsp_master, head);
-		if(head == -1) // no more work left
+		unsigned victim = self + i;
+		if(victim >= dsp_master->num_active)
+			victim -= dsp_master->num_active;
+
+		const int node = _dsp_deque_steal(&dsp_master->deques[victim]);
+		if(node != DSP_NODE_NONE)
+			return node;
+	}
+
+	return DSP_NODE_NONE;
+}
+
+__realtime static inline void
+_dsp_slave_spin(sp_app_t *app, dsp_master_t *dsp_master, unsigned self)
+{
+	const dsp_plan_t *plan = atomic_load_explicit(&dsp_master->plan, memory_order_acquire);
+	dsp_deque_t *deque = &dsp_master->deques[self];
+
+	while(!atomic_load_explicit(&dsp_master->emergency_exit, memory_order_relaxed))
+	{
+		int node = _dsp_deque_take(deque);
+
+		if(node == DSP_NODE_NONE)
 		{
-			break;
+			if(atomic_load_explicit(&dsp_master->num_done, memory_order_acquire)
+					>= plan->num_nodes)
+				break; // no more work left
+
+			node = _dsp_slave_steal(dsp_master, self);
+
+			if(node == DSP_NODE_NONE)
+			{
+				_dsp_pause();
+				continue; // spin
+			}
 		}
+
+		_dsp_slave_run(dsp_master, plan, deque, node);
 	}
+}
 
-	if(post)
+// spin on generation counter for a while, then block until it changes
+__realtime static inline unsigned
+_dsp_slave_wait(dsp_master_t *dsp_master, unsigned generation, unsigned spin_budget)
+{
+	for(unsigned i=0; i<spin_budget; i++)
 	{
-		sem_post(&dsp_master->sem);
+		const unsigned current = atomic_load_explicit(&dsp_master->generation,
+			memory_order_acquire);
+		if(current != generation)
+			return current;
+
+		_dsp_pause();
+	}
+
+	atomic_fetch_add(&dsp_master->num_sleeping, 1);
+
+	unsigned current;
+	while( (current = atomic_load(&dsp_master->generation)) == generation)
+	{
+#if defined(__linux__)
+		syscall(SYS_futex, &dsp_master->generation, FUTEX_WAIT_PRIVATE, generation,
+			NULL, NULL, 0);
+#else
+		sem_wait(&dsp_master->sem);
+#endif
 	}
+
+	atomic_fetch_sub(&dsp_master->num_sleeping, 1);
+
+	return current;
 }
 
 __non_realtime static void *
@@ -757,7 +1389,7 @@ _dsp_slave_thread(void *data)
 	dsp_slave_t *dsp_slave = data;
 	dsp_master_t *dsp_master = dsp_slave->dsp_master;
 	sp_app_t *app = (void *)dsp_master - offsetof(sp_app_t, dsp_master);
-	const int num = dsp_slave - dsp_master->dsp_slaves + 1;
+	const unsigned num = dsp_slave - dsp_master->dsp_slaves + 1;
 	//printf("thread: %i\n", num);
 
 	const pthread_t self = pthread_self();
@@ -774,88 +1406,129 @@ _dsp_slave_thread(void *data)
 
 	if(app->driver->cpu_affinity)
 	{
-		cpu_set_t cpuset;
-		CPU_ZERO(&cpuset);
-		CPU_SET(num, &cpuset);
-		if(pthread_setaffinity_np(self, sizeof(cpu_set_t), &cpuset))
+		if(sp_app_cpu_affinity(app->cpus, app->num_cpus, num, self))
 			sp_app_log_error(app, "%s: pthread_setaffinity_np error\n", __func__);
 	}
 
+	unsigned generation = atomic_load(&dsp_master->generation);
+	unsigned spin_budget = 0;
+
 	while(true)
 	{
-		sem_wait(&dsp_slave->sem);
-
-		_dsp_slave_spin(app, dsp_master, true);
+		generation = _dsp_slave_wait(dsp_master, generation, spin_budget);
 
 		if(atomic_load(&dsp_master->kill))
 			break;
 
-		//sched_yield();
+		// participation as published along with the generation this thread saw,
+		// thus a late wake-up never counts for a later cycle as well
+		if(num >= (generation & DSP_CYCLE_ACTIVE_MASK))
+		{
+			spin_budget = 0; // not needed in this cycle, block right away next time
+			continue;
+		}
+
+		_dsp_slave_spin(app, dsp_master, num);
+
+		atomic_fetch_add_explicit(&dsp_master->num_finished, 1, memory_order_release);
+		spin_budget = dsp_master->spin_budget;
 	}
 
 	return NULL;
 }
 
 __realtime static inline void
-_dsp_master_post(dsp_master_t *dsp_master, unsigned num)
+_dsp_master_post(dsp_master_t *dsp_master)
 {
-	for(unsigned i=0; i<num; i++)
-	{
-		dsp_slave_t *dsp_slave = &dsp_master->dsp_slaves[i];
+	atomic_store_explicit(&dsp_master->num_finished, 0, memory_order_relaxed);
+
+	// start cycle, publish participating threads with new generation in one word
+	const unsigned generation = atomic_load_explicit(&dsp_master->generation,
+		memory_order_relaxed);
+	atomic_store(&dsp_master->generation,
+		( (generation & ~DSP_CYCLE_ACTIVE_MASK) + (1U << DSP_CYCLE_ACTIVE_BITS) )
+		| dsp_master->num_active);
+
+	// only wake up slaves that are blocked
+	const unsigned num_sleeping = atomic_load(&dsp_master->num_sleeping);
+	if(num_sleeping == 0)
+		return;
 
-		sem_post(&dsp_slave->sem);
-	}
+#if defined(__linux__)
+	syscall(SYS_futex, &dsp_master->generation, FUTEX_WAKE_PRIVATE, INT_MAX,
+		NULL, NULL, 0);
+#else
+	for(unsigned i=0; i<num_sleeping; i++)
+		sem_post(&dsp_master->sem);
+#endif
 }
 
 __realtime static inline void
 _dsp_master_wait(sp_app_t *app, dsp_master_t *dsp_master, unsigned num)
 {
-	// derive timeout
-	struct timespec to;
-	cross_clock_gettime(&app->clk_real, &to);
-	to.tv_sec += 1; // if workers have not finished in due 1s, do emergency exit!
+	struct timespec to = { .tv_sec = 0, .tv_nsec = 0 };
 
-	// wait for worker threads to have finished
-	for(unsigned c = 0; c < num; )
+	// spin until slaves have finished
+	for(unsigned i=1;
+		atomic_load_explicit(&dsp_master->num_finished, memory_order_acquire) < num;
+		i++)
 	{
-		if(sem_timedwait(&dsp_master->sem, &to) == -1)
+		_dsp_pause();
+
+		if(i % 0x1000)
+			continue; // only check clock once in a while
+
+		struct timespec now;
+		cross_clock_gettime(&app->clk_mono, &now);
+
+		if(to.tv_sec == 0)
 		{
-			switch(errno)
-			{
-				case ETIMEDOUT:
-				{
-					atomic_store(&dsp_master->emergency_exit, true);
-				} continue;
-				case EINTR:
-				{
-					// nothing
-				} continue;
-			}
+			to.tv_sec = now.tv_sec + 1; // if slaves have not finished in due 1s, do emergency exit!
+			to.tv_nsec = now.tv_nsec;
+		}
+		else if( (now.tv_sec > to.tv_sec)
+			|| ( (now.tv_sec == to.tv_sec) && (now.tv_nsec > to.tv_nsec) ) )
+		{
+			atomic_store(&dsp_master->emergency_exit, true);
 		}
-
-		c++;
 	}
 }
 
 __realtime static inline void
 _dsp_master_process(sp_app_t *app, dsp_master_t *dsp_master, unsigned nsamples)
 {
-	for(unsigned m=0; m<app->num_mods; m++)
+	const dsp_plan_t *plan = atomic_load_explicit(&dsp_master->plan, memory_order_acquire);
+
+	unsigned num_slaves = dsp_master->concurrent - 1;
+	if(num_slaves > dsp_master->num_slaves)
+		num_slaves = dsp_master->num_slaves;
+
+	for(unsigned i=0; i<plan->num_nodes; i++)
 	{
-		mod_t *mod = app->mods[m];
-		dsp_client_t *dsp_client = &mod->dsp_client;
+		atomic_store_explicit(&plan->ref_counts[i], plan->num_sources[i],
+			memory_order_relaxed);
+	}
+	atomic_store_explicit(&dsp_master->num_done, 0, memory_order_relaxed);
+
+	dsp_master->num_active = num_slaves + 1;
+	for(unsigned i=0; i<dsp_master->num_active; i++)
+	{
+		dsp_deque_t *deque = &dsp_master->deques[i];
 
-		atomic_store(&dsp_client->ref_count, dsp_client->num_sources);
+		deque->nodes = &plan->queues[i * plan->num_nodes];
+		atomic_store_explicit(&deque->top, 0, memory_order_relaxed);
+		atomic_store_explicit(&deque->bottom, 0, memory_order_relaxed);
 	}
 
-	dsp_master->nsamples = nsamples;
+	// distribute nodes without dependencies over participating threads, push in
+	// reverse, so each thread takes its root with the longest path first
+	for(unsigned r=plan->num_roots; r-- > 0; )
+		_dsp_deque_push(&dsp_master->deques[r % dsp_master->num_active], plan->roots[r]);
 
-	unsigned num_slaves = dsp_master->concurrent - 1;
-	if(num_slaves > dsp_master->num_slaves)
-		num_slaves = dsp_master->num_slaves;
+	dsp_master->nsamples = nsamples;
 
-	_dsp_master_post(dsp_master, num_slaves); // wake up other slaves
-	_dsp_slave_spin(app, dsp_master, false); // runs jobs itself 
+	_dsp_master_post(dsp_master); // wake up other slaves
+	_dsp_slave_spin(app, dsp_master, 0); // runs jobs itself
 	_dsp_master_wait(app, dsp_master, num_slaves);
 }
 
@@ -867,6 +1540,12 @@ _sp_app_reset(sp_app_t *app)
 
 	app->num_mods = 0;
 
+	// invalidate execution plan, as it refers to deleted modules
+	_sp_app_order(app);
+
+	// drop pending stashes, as they refer to deleted modules
+	atomic_store_explicit(&app->stashes, NULL, memory_order_relaxed);
+
 	for(int m=0; m<num_mods; m++)
 		_sp_app_mod_del(app, app->mods[m]);
 }
@@ -902,6 +1581,8 @@ _sp_app_populate(sp_app_t *app)
 	{
 		sp_app_log_error(app, "%s: failed to create system sink\n", __func__);
 	}
+
+	_sp_app_order(app);
 }
 
 sp_app_t *
@@ -916,10 +1597,20 @@ sp_app_new(const LilvWorld *world, sp_app_driver_t *driver, void *data)
 	if(!app)
 		return NULL;
 
+	app->mods = calloc(MIN_MODS, sizeof(mod_t *));
+	if(!app->mods)
+	{
+		free(app);
+		return NULL;
+	}
+	app->max_mods = MIN_MODS;
+
 	atomic_init(&app->visibility, false);
 
 	atomic_init(&app->dirty, false);
 
+	atomic_init(&app->stashes, NULL);
+
 	app->dir.home = getenv("HOME");
 
 	//printf("%s %s %s\n", app->dir.home, app->dir.config, app->dir.data);
@@ -937,6 +1628,7 @@ sp_app_new(const LilvWorld *world, sp_app_driver_t *driver, void *data)
 		app->world = lilv_world_new();
 		if(!app->world)
 		{
+			free(app->mods);
 			free(app);
 			return NULL;
 		}
@@ -964,7 +1656,33 @@ sp_app_new(const LilvWorld *world, sp_app_driver_t *driver, void *data)
 	app->fps.bound = driver->sample_rate / driver->update_rate;
 	app->fps.counter = 0;
 
+	const float feedback_rate = (driver->feedback_rate > 0.f)
+		? driver->feedback_rate
+		: driver->update_rate;
+	app->feedback.bound = (feedback_rate > 0.f)
+		? driver->sample_rate / feedback_rate
+		: 0; // flush every period
+	app->feedback.counter = 0;
+	app->feedback.timeout = false;
+
 	app->ramp_samples = driver->sample_rate / 10; // ramp over 0.1s FIXME make this configurable
+	_sp_app_mix_init(app);
+	app->skip_silence = driver->skip_silence;
+	app->pipelined = driver->pipelined;
+	atomic_init(&app->latency, 0);
+
+	// split-run mode would violate fixed block lengths
+	app->split_pow2 = driver->features & SP_APP_FEATURE_POWER_OF_2_BLOCK_LENGTH;
+	app->split_frames = (driver->features & SP_APP_FEATURE_FIXED_BLOCK_LENGTH)
+		? 0 : driver->split_frames;
+	if(app->split_pow2)
+	{
+		uint32_t pow2 = 1;
+		while(pow2 < app->split_frames)
+			pow2 <<= 1;
+
+		app->split_frames = app->split_frames ? pow2 : 0;
+	}
 
 	// populate uri_to_id
 	app->uri_to_id.callback_data = app;
@@ -993,15 +1711,37 @@ sp_app_new(const LilvWorld *world, sp_app_driver_t *driver, void *data)
 	atomic_init(&dsp_master->kill, false);
 	atomic_init(&dsp_master->emergency_exit, false);
 	atomic_init(&dsp_master->xrun_report, false);
+	atomic_init(&dsp_master->generation, 0);
+	atomic_init(&dsp_master->num_sleeping, 0);
+	atomic_init(&dsp_master->num_finished, 0);
+	dsp_master->spin_budget = driver->spin_budget;
+#if !defined(__linux__)
 	sem_init(&dsp_master->sem, 0, 0);
-	dsp_master->num_slaves = driver->num_slaves;
+#endif
+
+	dsp_master->dsp_slaves = calloc(driver->num_slaves + 1, sizeof(dsp_slave_t));
+	dsp_master->deques = aligned_alloc(alignof(dsp_deque_t),
+		(driver->num_slaves + 1) * sizeof(dsp_deque_t));
+	dsp_master->graph = _dsp_graph_new(MIN_MODS, MIN_EDGES);
+	if(!dsp_master->dsp_slaves || !dsp_master->deques || !dsp_master->graph)
+	{
+		sp_app_log_error(app, "%s: parallel processing allocation failed\n", __func__);
+		sp_app_free(app);
+		return NULL;
+	}
+	memset(dsp_master->deques, 0x0, (driver->num_slaves + 1) * sizeof(dsp_deque_t));
+
+	dsp_master->num_slaves = (driver->num_slaves < DSP_CYCLE_ACTIVE_MASK)
+		? driver->num_slaves
+		: DSP_CYCLE_ACTIVE_MASK - 1; // must fit into generation word
 	dsp_master->concurrent = dsp_master->num_slaves + 1; // this is a safe fallback
+	if(driver->cpu_affinity)
+		app->num_cpus = sp_app_cpu_order(&driver->cpu_set, app->cpus);
 	for(unsigned i=0; i<dsp_master->num_slaves; i++)
 	{
 		dsp_slave_t *dsp_slave = &dsp_master->dsp_slaves[i];
 
 		dsp_slave->dsp_master = dsp_master;
-		sem_init(&dsp_slave->sem, 0, 0);
 		pthread_attr_t attr;
 		pthread_attr_init(&attr);
 		pthread_create(&dsp_slave->thread, &attr, _dsp_slave_thread, dsp_slave);
@@ -1021,6 +1761,18 @@ sp_app_run_pre(sp_app_t *app, uint32_t nsamples)
 
 	cross_clock_gettime(&app->clk_mono, &app->prof.t1);
 
+	// retry stashing control port values that were locked last time
+	port_t *next;
+	for(port_t *port = atomic_exchange_explicit(&app->stashes, NULL, memory_order_acquire);
+		port;
+		port = next)
+	{
+		next = port->control.stash_next;
+
+		port->control.stashing = false;
+		_sp_app_port_control_stash(port);
+	}
+
 	// iterate over all modules
 	for(unsigned m=0; m<app->num_mods; m++)
 	{
@@ -1032,30 +1784,16 @@ sp_app_run_pre(sp_app_t *app, uint32_t nsamples)
 			mod->delete_request = false;
 		}
 
-		for(unsigned p=0; p<mod->num_ports; p++)
+		// clear atom sequence input buffers
+		for(unsigned i=0; i<mod->num_seq_ins; i++)
 		{
-			port_t *port = &mod->ports[p];
-
-			// stash control port values
-			if( (port->type == PORT_TYPE_CONTROL) && port->control.stashing)
-			{
-				port->control.stashing = false;
-				_sp_app_port_control_stash(port);
-			}
-
-			if(port->direction == PORT_DIRECTION_OUTPUT)
-				continue; // ignore output ports
+			port_t *port = &mod->ports[mod->seq_ports[i]];
 
-			// clear atom sequence input buffers
-			if(  (port->type == PORT_TYPE_ATOM)
-				&& (port->atom.buffer_type == PORT_BUFFER_TYPE_SEQUENCE) )
-			{
-				LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
-				seq->atom.size = sizeof(LV2_Atom_Sequence_Body); // empty sequence
-				seq->atom.type = app->regs.port.sequence.urid;
-				seq->body.unit = 0;
-				seq->body.pad = 0;
-			}
+			LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
+			seq->atom.size = sizeof(LV2_Atom_Sequence_Body); // empty sequence
+			seq->atom.type = app->regs.port.sequence.urid;
+			seq->body.unit = 0;
+			seq->body.pad = 0;
 		}
 	}
 
@@ -1103,8 +1841,18 @@ sp_app_run_post(sp_app_t *app, uint32_t nsamples)
 		app->fps.counter -= app->fps.bound; // reset sample counter
 	}
 
+	app->feedback.counter += nsamples;
+	app->feedback.timeout = (app->feedback.counter >= app->feedback.bound);
+	if(app->feedback.timeout)
+		app->feedback.counter -= app->feedback.bound;
+
 	dsp_master_t *dsp_master = &app->dsp_master;
-	if( (dsp_master->num_slaves > 0) && (dsp_master->concurrent > 1) ) // parallel processing makes sense here
+	dsp_plan_t *plan = atomic_load_explicit(&dsp_master->plan, memory_order_acquire);
+	if(plan && (plan->version != dsp_master->version))
+		plan = NULL; // outdated, worker is compiling new one
+
+	if(  plan && (dsp_master->num_slaves > 0)
+		&& (dsp_master->concurrent > 1) ) // parallel processing makes sense here
 	{
 		_sp_app_process_parallel(app, nsamples, sparse_update_timeout);
 	}
@@ -1113,6 +1861,16 @@ sp_app_run_post(sp_app_t *app, uint32_t nsamples)
 		_sp_app_process_serial(app, nsamples, sparse_update_timeout);
 	}
 
+	// hand over outputs of first to second pipeline stage, keeps going with
+	// previous stage split while plan is outdated
+	for(unsigned m=0; m<app->num_mods; m++)
+	{
+		mod_t *mod = app->mods[m];
+
+		if(mod->dsp_client.delayed)
+			_sp_app_mod_outputs_delay(mod, nsamples);
+	}
+
 	// profiling
 	struct timespec app_t2;
 	cross_clock_gettime(&app->clk_mono, &app_t2);
@@ -1174,43 +1932,23 @@ sp_app_run_post(sp_app_t *app, uint32_t nsamples)
 		}
 		else
 		{
-			// reset DAG weights
-			for(unsigned m=0; m<app->num_mods; m++)
-			{
-				mod_t *mod = app->mods[m];
-				dsp_client_t *dsp_client = &mod->dsp_client;
-
-				dsp_client->weight = 0;
-			}
-
 			unsigned T1 = 0;
 			unsigned Tinf = 0;
 
-			// calculate DAG weights
-			for(unsigned m1=0; m1<app->num_mods; m1++)
+			// calculate DAG weights along topologically sorted plan
+			for(unsigned i=0; plan && (i<plan->num_nodes); i++)
 			{
-				mod_t *mod1 = app->mods[m1];
+				mod_t *mod1 = plan->mods[i];
 				dsp_client_t *dsp_client1 = &mod1->dsp_client;
 
-				unsigned gsw = 0; // greatest sink weight
+				unsigned gsw = 0; // greatest source weight
 
-				for(unsigned m2=0; m2<m1; m2++)
+				for(unsigned j=plan->sources_offset[i]; j<plan->sources_offset[i+1]; j++)
 				{
-					mod_t *mod2 = app->mods[m2];
-					dsp_client_t *dsp_client2 = &mod2->dsp_client;
-
-					for(unsigned s=0; s<dsp_client2->num_sinks; s++)
-					{
-						dsp_client_t *dsp_client3 = dsp_client2->sinks[s];
-
-						if(dsp_client3 == dsp_client1) // mod2 is source of mod1
-						{
-							if(dsp_client2->weight > gsw)
-								gsw = dsp_client2->weight;
+					dsp_client_t *dsp_client2 = &plan->mods[plan->sources[j]]->dsp_client;
 
-							break;
-						}
-					}
+					if(dsp_client2->weight > gsw)
+						gsw = dsp_client2->weight;
 				}
 
 				const unsigned w1 = mod1->prof.sum;
@@ -1222,6 +1960,30 @@ sp_app_run_post(sp_app_t *app, uint32_t nsamples)
 					Tinf = dsp_client1->weight;
 			}
 
+			// calculate ranks along reversely sorted plan
+			for(unsigned i=plan ? plan->num_nodes : 0; i-- > 0; )
+			{
+				mod_t *mod1 = plan->mods[i];
+				dsp_client_t *dsp_client1 = &mod1->dsp_client;
+
+				unsigned gsr = 0; // greatest sink rank
+
+				for(unsigned j=plan->sinks_offset[i]; j<plan->sinks_offset[i+1]; j++)
+				{
+					dsp_client_t *dsp_client2 = &plan->mods[plan->sinks[j]]->dsp_client;
+
+					if(dsp_client2->rank > gsr)
+						gsr = dsp_client2->rank;
+				}
+
+				dsp_client1->rank = gsr + mod1->prof.sum;
+				plan->ranks[i] = dsp_client1->rank;
+			}
+
+			// schedule nodes on critical path first, slaves are idle at this point
+			if(plan)
+				_dsp_plan_prioritize(plan);
+
 			// derive average parallelism
 			const float parallelism = (float)T1 / Tinf; //TODO add some head-room?
 			app->dsp_master.concurrent = ceilf(parallelism);
@@ -1347,10 +2109,16 @@ sp_app_run_post(sp_app_t *app, uint32_t nsamples)
 		// to nk
 		_sp_app_ui_set_modlist(app, 0, 0); //FIXME subj, seqn
 
-		// recalculate concurrency
-		_dsp_master_reorder(app);
+		// recalculate order and concurrency
+		_sp_app_order(app);
 		//printf("concurrency: %i\n", app->dsp_master.concurrent);
 	}
+
+	// install plan compiled while worker owned graph
+	_dsp_master_unpark(app);
+
+	// have worker compile new plan if graph has changed
+	_dsp_master_snapshot(app);
 }
 
 void
@@ -1369,8 +2137,7 @@ sp_app_free(sp_app_t *app)
 	dsp_master_t *dsp_master = &app->dsp_master;
 	atomic_store(&dsp_master->kill, true);
 	//printf("finish\n");
-	_dsp_master_post(dsp_master, dsp_master->num_slaves);
-	_dsp_master_wait(app, dsp_master, dsp_master->num_slaves);
+	_dsp_master_post(dsp_master);
 
 	for(unsigned i=0; i<dsp_master->num_slaves; i++)
 	{
@@ -1378,13 +2145,29 @@ sp_app_free(sp_app_t *app)
 
 		void *ret;
 		pthread_join(dsp_slave->thread, &ret);
-		sem_destroy(&dsp_slave->sem);
 	}
+#if !defined(__linux__)
 	sem_destroy(&dsp_master->sem);
+#endif
+
+	if(dsp_master->dsp_slaves)
+		free(dsp_master->dsp_slaves);
+	if(dsp_master->deques)
+		free(dsp_master->deques);
+	if(dsp_master->graph)
+		free(dsp_master->graph);
+	if(dsp_master->scratch)
+		free(dsp_master->scratch);
+	dsp_plan_t *plan = atomic_load_explicit(&dsp_master->plan, memory_order_relaxed);
+	if(plan)
+		_dsp_plan_free(plan);
+	if(dsp_master->parked)
+		_dsp_plan_free(dsp_master->parked);
 
 	// free mods
 	for(unsigned m=0; m<app->num_mods; m++)
 		_sp_app_mod_del(app, app->mods[m]);
+	free(app->mods);
 
 	sp_regs_deinit(&app->regs);
 
@@ -1405,6 +2188,80 @@ sp_app_free(sp_app_t *app)
 	free(app);
 }
 
+static int
+_cpu_numa_node(unsigned cpu)
+{
+	char path [64];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+
+	DIR *dir = opendir(path);
+	if(!dir)
+		return -1;
+
+	int node = -1;
+	struct dirent *entry;
+	while((entry = readdir(dir)))
+	{
+		if(sscanf(entry->d_name, "node%d", &node) == 1)
+			break;
+	}
+	closedir(dir);
+
+	return node;
+}
+
+// list CPUs of set, CPUs on the NUMA node of the first one go first, reads
+// sysfs, so do this once before any thread gets pinned
+__non_realtime unsigned
+sp_app_cpu_order(const cpu_set_t *cpu_set, uint16_t *cpus)
+{
+	int nodes [CPU_SETSIZE];
+	int home = -1;
+
+	for(unsigned cpu=0; cpu<CPU_SETSIZE; cpu++)
+	{
+		if(!CPU_ISSET(cpu, cpu_set))
+			continue;
+
+		nodes[cpu] = _cpu_numa_node(cpu);
+		if(home == -1)
+			home = nodes[cpu];
+	}
+
+	unsigned num_cpus = 0;
+	for(unsigned pass=0; pass<2; pass++)
+	{
+		for(unsigned cpu=0; cpu<CPU_SETSIZE; cpu++)
+		{
+			if(!CPU_ISSET(cpu, cpu_set))
+				continue;
+
+			const bool local = (nodes[cpu] == home);
+			if(local != (pass == 0))
+				continue; // local CPUs in first pass, remote ones in second
+
+			cpus[num_cpus++] = cpu;
+		}
+	}
+
+	return num_cpus;
+}
+
+// pin thread to n-th CPU of list as of sp_app_cpu_order
+__realtime int
+sp_app_cpu_affinity(const uint16_t *cpus, unsigned num_cpus, unsigned num,
+	pthread_t thread)
+{
+	if(num_cpus == 0)
+		return -1;
+
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpus[num % num_cpus], &cpuset);
+
+	return pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+}
+
 bool
 sp_app_bypassed(sp_app_t *app)
 {
@@ -1430,6 +2287,8 @@ sp_app_options_set(sp_app_t *app, const LV2_Options_Option *options)
 static void
 _sp_app_reinitialize(sp_app_t *app)
 {
+	_sp_app_order(app); // back to private buffers, shared ones may be too small
+
 	for(unsigned m=0; m<app->num_mods; m++)
 	{
 		mod_t *mod = app->mods[m];
@@ -1448,6 +2307,7 @@ _sp_app_reinitialize(sp_app_t *app)
 
 			// set port buffer
 			lilv_instance_connect_port(mod->inst, i, tar->base);
+			tar->alias = NULL;
 		}
 
 		lilv_instance_activate(mod->inst);
@@ -1534,62 +2394,54 @@ sp_app_com_event(sp_app_t *app, LV2_URID otype)
 	return 1;
 }
 
-// sort according to position
-__realtime static void
-_sp_app_mod_qsort(mod_t **A, int n)
+// graph has changed, invalidate execution plan and have worker compile a new
+// one at the end of this period, run serially in previous order and with
+// previous pipeline stages until then
+__realtime void
+_sp_app_order(sp_app_t *app)
 {
-	if(n < 2)
-		return;
+	dsp_master_t *dsp_master = &app->dsp_master;
 
-	const mod_t *p = A[0];
+	dsp_master->version += 1;
+	dsp_master->stale = true;
 
-	int i = -1;
-	int j = n;
+	_dsp_master_unbind(app); // back to private buffers
 
-	while(true)
+	for(unsigned m=0; m<app->num_mods; m++)
 	{
-		do {
-			i += 1;
-		} while( (A[i]->pos.x < p->pos.x) || ( (A[i]->pos.x == p->pos.x) && (A[i]->pos.y < p->pos.y) ) );
-
-		do {
-			j -= 1;
-		} while( (A[j]->pos.x > p->pos.x) || ( (A[j]->pos.x == p->pos.x) && (A[j]->pos.y > p->pos.y) ) );
+		mod_t *mod = app->mods[m];
 
-		if(i >= j)
-			break;
+		mod->routed = false;
+		for(unsigned p=0; p<mod->num_ports; p++)
+		{
+			port_t *port = &mod->ports[p];
 
-		mod_t *tmp = A[i];
-		A[i] = A[j];
-		A[j] = tmp;
+			if( (port->type == PORT_TYPE_ATOM) && port->atom.auto_events)
+			{
+				port->atom.routed = false;
+				port->atom.num_auto_events = -1; // not parsed yet
+			}
+		}
 	}
 
-	_sp_app_mod_qsort(A, j + 1);
-	_sp_app_mod_qsort(A + j + 1, n - j - 1);
-}
-
-/*
-__non_realtime static void
-_sp_app_order_dump(sp_app_t *app)
-{
-	for(unsigned m = 0; m < app->num_mods; m++)
+	// mark outputs feeding automation inputs to be parsed once by router
+	for(unsigned m=0; m<app->num_mods; m++)
 	{
 		mod_t *mod = app->mods[m];
+		port_t *auto_port = &mod->ports[mod->num_ports - 2];
+		connectable_t *conn = &auto_port->atom.connectable;
 
-		printf("%u: %u\n", m, mod->uid);
-	}
-	printf("\n");
-}
-*/
-
-__realtime void
-_sp_app_order(sp_app_t *app)
-{
-	//_sp_app_order_dump(app);
-	_sp_app_mod_qsort(app->mods, app->num_mods);
-	//_sp_app_order_dump(app);
+		for(int s=0; s<conn->num_sources; s++)
+		{
+			port_t *src_port = conn->sources[s].port;
 
-	_dsp_master_reorder(app);
+			if(src_port->atom.auto_events)
+			{
+				src_port->atom.routed = true;
+				src_port->mod->routed = true;
+			}
+		}
+	}
 }
 
 __non_realtime int
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2015-2016 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+#include <synthpod_app_private.h>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+#if defined(HAS_BUILTIN_CPU_SUPPORTS) && (defined(__x86_64__) || defined(__i386__))
+#	include <immintrin.h>
+#	define USE_AVX2
+#endif
+
+#if defined(__ARM_NEON)
+#	include <arm_neon.h>
+#endif
+
+// mixing kernels either copy (first source) or accumulate (further sources)
+// source to sink, gain is interpolated linearly from gain0 at first sample
+// towards gain1 at first sample of next period
+
+__realtime static inline void
+_mix_generic(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples, bool add)
+{
+	const float step = (gain1 - gain0) / nsamples;
+
+	dst = ASSUME_CACHE_ALIGNED(dst);
+	src = ASSUME_CACHE_ALIGNED(src);
+
+	if(step == 0.f) // constant gain
+	{
+		if(gain0 == 1.f)
+		{
+			if(add)
+			{
+				for(uint32_t j=0; j<nsamples; j++)
+					dst[j] += src[j];
+			}
+			else
+			{
+				memcpy(dst, src, nsamples * sizeof(float));
+			}
+		}
+		else
+		{
+			if(add)
+			{
+				for(uint32_t j=0; j<nsamples; j++)
+					dst[j] += src[j] * gain0;
+			}
+			else
+			{
+				for(uint32_t j=0; j<nsamples; j++)
+					dst[j] = src[j] * gain0;
+			}
+		}
+	}
+	else // ramped gain
+	{
+		if(add)
+		{
+			for(uint32_t j=0; j<nsamples; j++)
+				dst[j] += src[j] * (gain0 + step*j);
+		}
+		else
+		{
+			for(uint32_t j=0; j<nsamples; j++)
+				dst[j] = src[j] * (gain0 + step*j);
+		}
+	}
+}
+
+__realtime static void
+_mix_copy_generic(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_generic(dst, src, gain0, gain1, nsamples, false);
+}
+
+__realtime static void
+_mix_add_generic(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_generic(dst, src, gain0, gain1, nsamples, true);
+}
+
+#if defined(__SSE2__)
+__realtime static inline void
+_mix_sse2(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples, bool add)
+{
+	const float step = (gain1 - gain0) / nsamples;
+	const __m128 dg = _mm_set1_ps(4*step);
+	__m128 g = _mm_add_ps(_mm_set1_ps(gain0),
+		_mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0.f, 1.f, 2.f, 3.f)));
+	uint32_t j = 0;
+
+	for( ; j + 4 <= nsamples; j += 4)
+	{
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(&src[j]), g);
+
+		if(add)
+			v = _mm_add_ps(_mm_loadu_ps(&dst[j]), v);
+
+		_mm_storeu_ps(&dst[j], v);
+		g = _mm_add_ps(g, dg);
+	}
+
+	for( ; j<nsamples; j++) // remainder
+	{
+		const float v = src[j] * (gain0 + step*j);
+
+		dst[j] = add ? dst[j] + v : v;
+	}
+}
+
+__realtime static void
+_mix_copy_sse2(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_sse2(dst, src, gain0, gain1, nsamples, false);
+}
+
+__realtime static void
+_mix_add_sse2(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_sse2(dst, src, gain0, gain1, nsamples, true);
+}
+#endif
+
+#if defined(USE_AVX2)
+__attribute__((target("avx2")))
+__realtime static inline void
+_mix_avx2(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples, bool add)
+{
+	const float step = (gain1 - gain0) / nsamples;
+	const __m256 dg = _mm256_set1_ps(8*step);
+	__m256 g = _mm256_add_ps(_mm256_set1_ps(gain0),
+		_mm256_mul_ps(_mm256_set1_ps(step),
+			_mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f)));
+	uint32_t j = 0;
+
+	for( ; j + 8 <= nsamples; j += 8)
+	{
+		__m256 v = _mm256_mul_ps(_mm256_loadu_ps(&src[j]), g);
+
+		if(add)
+			v = _mm256_add_ps(_mm256_loadu_ps(&dst[j]), v);
+
+		_mm256_storeu_ps(&dst[j], v);
+		g = _mm256_add_ps(g, dg);
+	}
+
+	for( ; j<nsamples; j++) // remainder
+	{
+		const float v = src[j] * (gain0 + step*j);
+
+		dst[j] = add ? dst[j] + v : v;
+	}
+}
+
+__attribute__((target("avx2")))
+__realtime static void
+_mix_copy_avx2(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_avx2(dst, src, gain0, gain1, nsamples, false);
+}
+
+__attribute__((target("avx2")))
+__realtime static void
+_mix_add_avx2(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_avx2(dst, src, gain0, gain1, nsamples, true);
+}
+#endif
+
+#if defined(__ARM_NEON)
+__realtime static inline void
+_mix_neon(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples, bool add)
+{
+	const float step = (gain1 - gain0) / nsamples;
+	const float32x4_t dg = vdupq_n_f32(4*step);
+	const float lanes [4] = {0.f, 1.f, 2.f, 3.f};
+	float32x4_t g = vmlaq_f32(vdupq_n_f32(gain0), vdupq_n_f32(step), vld1q_f32(lanes));
+	uint32_t j = 0;
+
+	for( ; j + 4 <= nsamples; j += 4)
+	{
+		const float32x4_t s = vld1q_f32(&src[j]);
+
+		if(add)
+			vst1q_f32(&dst[j], vmlaq_f32(vld1q_f32(&dst[j]), s, g));
+		else
+			vst1q_f32(&dst[j], vmulq_f32(s, g));
+
+		g = vaddq_f32(g, dg);
+	}
+
+	for( ; j<nsamples; j++) // remainder
+	{
+		const float v = src[j] * (gain0 + step*j);
+
+		dst[j] = add ? dst[j] + v : v;
+	}
+}
+
+__realtime static void
+_mix_copy_neon(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_neon(dst, src, gain0, gain1, nsamples, false);
+}
+
+__realtime static void
+_mix_add_neon(float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples)
+{
+	_mix_neon(dst, src, gain0, gain1, nsamples, true);
+}
+#endif
+
+// pick widest kernels supported by build and running CPU
+__non_realtime void
+_sp_app_mix_init(sp_app_t *app)
+{
+	app->mix.copy = _mix_copy_generic;
+	app->mix.add = _mix_add_generic;
+
+#if defined(__SSE2__)
+	app->mix.copy = _mix_copy_sse2;
+	app->mix.add = _mix_add_sse2;
+#endif
+
+#if defined(USE_AVX2)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+	{
+		app->mix.copy = _mix_copy_avx2;
+		app->mix.add = _mix_add_avx2;
+	}
+#endif
+
+#if defined(__ARM_NEON)
+	app->mix.copy = _mix_copy_neon;
+	app->mix.add = _mix_add_neon;
+#endif
+}
@@ -20,6 +20,10 @@
 
 #include <synthpod_app_private.h>
 
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
 #define ANSI_COLOR_BOLD    "\x1b[1m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 
@@ -153,10 +157,14 @@ _mod_make_path(LV2_State_Make_Path_Handle instance, const char *abstract_path)
 static inline int
 _sp_app_mod_alloc_pool(pool_t *pool)
 {
+	// whole cache lines, so modules on different cores never share one
+	pool->size = (pool->size + CACHE_LINE_SIZE - 1) & ~((size_t)CACHE_LINE_SIZE - 1);
+
 #if defined(_WIN32)
-	pool->buf = _aligned_malloc(pool->size, 8);
+	pool->buf = _aligned_malloc(pool->size, CACHE_LINE_SIZE);
 #else
-	posix_memalign(&pool->buf, 8, pool->size);
+	if(posix_memalign(&pool->buf, CACHE_LINE_SIZE, pool->size))
+		pool->buf = NULL;
 #endif
 	if(pool->buf)
 	{
@@ -173,7 +181,11 @@ _sp_app_mod_free_pool(pool_t *pool)
 {
 	if(pool->buf)
 	{
+#if defined(_WIN32)
+		_aligned_free(pool->buf);
+#else
 		free(pool->buf);
+#endif
 		pool->buf = NULL;
 	}
 }
@@ -195,6 +207,7 @@ _sp_app_mod_slice_pool(mod_t *mod, port_type_t type)
 
 			// define buffer slice
 			tar->base = ptr;
+			tar->priv = ptr;
 
 			// initialize control buffers to default value
 			if(tar->type == PORT_TYPE_CONTROL)
@@ -204,11 +217,304 @@ _sp_app_mod_slice_pool(mod_t *mod, port_type_t type)
 				float *buf_ptr = PORT_BASE_ALIGNED(tar);
 				*buf_ptr = control->dflt;
 				control->stash = control->dflt;
-				control->last = control->dflt;
-				control->auto_dirty = true;
 			}
 
-			ptr += lv2_atom_pad_size(tar->size);
+			ptr += _port_pad_size(tar->type, tar->size);
+		}
+	}
+}
+
+// collect control ports into arrays for vectorized change detection
+static inline int
+_sp_app_mod_ctrl_init(mod_t *mod)
+{
+	unsigned num = 0;
+	for(unsigned i=0; i<mod->num_ports; i++)
+	{
+		if(mod->ports[i].type == PORT_TYPE_CONTROL)
+			num += 1;
+	}
+
+	const unsigned words = (num + 63) / 64;
+
+	// single allocation for all arrays
+	uint8_t *data = calloc(1, words * 2 * sizeof(uint64_t)
+		+ num * (sizeof(float) + sizeof(unsigned)));
+	if(!data)
+		return -1;
+
+	mod->ctrl.num = num;
+	mod->ctrl.dirty = (uint64_t *)data;
+	mod->ctrl.auto_dirty = &mod->ctrl.dirty[words];
+	mod->ctrl.last = (float *)&mod->ctrl.auto_dirty[words];
+	mod->ctrl.ports = (unsigned *)&mod->ctrl.last[num];
+
+	// walk ports in the same order as the control pool has been sliced
+	const float *vals = mod->pools[PORT_TYPE_CONTROL].buf;
+	const size_t stride = _port_pad_size(PORT_TYPE_CONTROL, sizeof(float)) / sizeof(float);
+	bool tiled = true;
+	unsigned k = 0;
+
+	for(port_direction_t dir=0; dir<PORT_DIRECTION_NUM; dir++)
+	{
+		for(unsigned i=0; i<mod->num_ports; i++)
+		{
+			port_t *tar = &mod->ports[i];
+
+			if( (tar->type != PORT_TYPE_CONTROL) || (tar->direction != dir) )
+				continue; //skip
+
+			const float *buf_ptr = PORT_BASE_ALIGNED(tar);
+
+			if(buf_ptr != &vals[k * stride])
+				tiled = false; // e.g. due to port with custom minimum size
+
+			tar->control.slot = k;
+			mod->ctrl.ports[k] = i;
+			mod->ctrl.last[k] = *buf_ptr;
+			_ctrl_bit_set(mod->ctrl.auto_dirty, k);
+			k += 1;
+		}
+	}
+
+	mod->ctrl.vals = (tiled && (stride == 2)) ? vals : NULL;
+
+	return 0;
+}
+
+// refresh bitmap of control ports whose values differ from last notified ones
+__realtime void
+_sp_app_mod_controls_changed(mod_t *mod)
+{
+	const unsigned num = mod->ctrl.num;
+	const float *last = mod->ctrl.last;
+	uint64_t *dirty = mod->ctrl.dirty;
+	unsigned k = 0;
+
+	memset(dirty, 0x0, (num + 63) / 64 * sizeof(uint64_t));
+
+	if(mod->ctrl.vals) // values interleaved with padding in control pool
+	{
+		const float *vals = mod->ctrl.vals;
+
+#if defined(__SSE2__)
+		for( ; k + 4 <= num; k += 4)
+		{
+			// deinterleave 4 values from padded slots
+			const __m128 lo = _mm_loadu_ps(&vals[2*k]);
+			const __m128 hi = _mm_loadu_ps(&vals[2*k + 4]);
+			const __m128 v = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+			const uint64_t mask = _mm_movemask_ps(_mm_cmpneq_ps(v, _mm_loadu_ps(&last[k])));
+
+			dirty[k >> 6] |= mask << (k & 63);
+		}
+#endif
+
+		for( ; k<num; k++) // remainder
+		{
+			if(vals[2*k] != last[k])
+				_ctrl_bit_set(dirty, k);
+		}
+	}
+	else
+	{
+		for( ; k<num; k++)
+		{
+			const float *val = PORT_BASE_ALIGNED(&mod->ports[mod->ctrl.ports[k]]);
+
+			if(*val != last[k])
+				_ctrl_bit_set(dirty, k);
+		}
+	}
+}
+
+// refresh per-module lookup of automation slots by MIDI controller and OSC path
+__realtime void
+_sp_app_mod_automations_index(mod_t *mod)
+{
+	// only clear table entries in use
+	for(unsigned i = 0; i < MAX_AUTOMATIONS; i++)
+	{
+		const uint16_t key = mod->auto_index.midi_keys[i];
+
+		if(key)
+			mod->auto_index.midi[(key - 1) >> 7][(key - 1) & 0x7f] = 0;
+
+		mod->auto_index.midi_keys[i] = 0;
+	}
+	mod->auto_index.midi_any = 0;
+	memset(mod->auto_index.osc, 0x0, sizeof(mod->auto_index.osc));
+	mod->auto_index.osc_any = 0;
+
+	for(unsigned i = 0; i < MAX_AUTOMATIONS; i++)
+	{
+		auto_t *automation = &mod->automations[i];
+		const uint64_t slot = UINT64_C(1) << i;
+
+		if(automation->type == AUTO_TYPE_MIDI)
+		{
+			midi_auto_t *mauto = &automation->midi;
+
+			if(  automation->learning
+				|| (mauto->channel < 0) || (mauto->channel > 0xf)
+				|| (mauto->controller < 0) || (mauto->controller > 0x7f)
+				|| (mauto->mode != AUTO_MIDI_MODE_CC7) ) // 14-bit spans several controllers
+			{
+				mod->auto_index.midi_any |= slot;
+			}
+			else
+			{
+				mod->auto_index.midi[mauto->channel][mauto->controller] |= slot;
+				mod->auto_index.midi_keys[i] = ( (mauto->channel << 7) | mauto->controller) + 1;
+			}
+		}
+		else if(automation->type == AUTO_TYPE_OSC)
+		{
+			osc_auto_t *oauto = &automation->osc;
+
+			if(automation->learning || (oauto->path[0] == '\0') || oauto->pattern)
+			{
+				mod->auto_index.osc_any |= slot;
+			}
+			else
+			{
+				const uint32_t hash = _automation_osc_hash(oauto->path, sizeof(oauto->path));
+
+				mod->auto_index.osc[hash & 0x3f] |= slot;
+				mod->auto_index.osc_hashes[i] = hash;
+			}
+		}
+
+		if( (automation->type == AUTO_TYPE_NONE) || !automation->smoothing)
+			mod->auto_smoothing &= ~slot; // drop ramps of removed automations
+		if( (automation->type == AUTO_TYPE_NONE) || !automation->src_enabled)
+			mod->auto_feedback &= ~slot; // drop output of removed automations
+	}
+}
+
+// give atom outputs space for events parsed by automation router
+static inline int
+_sp_app_mod_auto_events_init(mod_t *mod)
+{
+	unsigned num = 0;
+	for(unsigned i=0; i<mod->num_ports; i++)
+	{
+		port_t *tar = &mod->ports[i];
+
+		if(  (tar->type == PORT_TYPE_ATOM) && (tar->direction == PORT_DIRECTION_OUTPUT)
+			&& (i != mod->num_ports - 4) // ignore dsp debug port
+			&& (i != mod->num_ports - 3) ) // ignore ui debug port
+		{
+			tar->atom.num_auto_events = -1;
+			num += 1;
+		}
+	}
+
+	if(!num)
+		return 0;
+
+	mod->auto_events = calloc(num * MAX_AUTO_EVENTS, sizeof(auto_event_t));
+	if(!mod->auto_events)
+		return -1;
+
+	auto_event_t *ptr = mod->auto_events;
+	for(unsigned i=0; i<mod->num_ports; i++)
+	{
+		port_t *tar = &mod->ports[i];
+
+		if(  (tar->type == PORT_TYPE_ATOM) && (tar->direction == PORT_DIRECTION_OUTPUT)
+			&& (i != mod->num_ports - 4) // ignore dsp debug port
+			&& (i != mod->num_ports - 3) ) // ignore ui debug port
+		{
+			tar->atom.auto_events = ptr;
+			ptr += MAX_AUTO_EVENTS;
+		}
+	}
+
+	return 0;
+}
+
+// collect atom sequence ports which need reinitialization every cycle
+static inline int
+_sp_app_mod_seq_ports_init(mod_t *mod)
+{
+	mod->num_seq_ins = 0;
+	mod->num_seq_outs = 0;
+	mod->seq_ports = calloc(mod->num_ports, sizeof(unsigned));
+	if(!mod->seq_ports)
+		return -1;
+
+	// plugins with event ports can't be split-run, sequences would need slicing
+	mod->splittable = !mod->system_ports;
+	for(unsigned i=0; i<mod->num_ports - 4; i++)
+	{
+		if(mod->ports[i].type == PORT_TYPE_ATOM)
+			mod->splittable = false;
+	}
+
+	for(unsigned i=0; i<mod->num_ports; i++)
+	{
+		port_t *tar = &mod->ports[i];
+
+		if(  (tar->type == PORT_TYPE_ATOM)
+			&& (tar->atom.buffer_type == PORT_BUFFER_TYPE_SEQUENCE)
+			&& (tar->direction == PORT_DIRECTION_INPUT) )
+		{
+			mod->seq_ports[mod->num_seq_ins++] = i;
+		}
+	}
+
+	for(unsigned i=0; i<mod->num_ports; i++)
+	{
+		port_t *tar = &mod->ports[i];
+
+		if(  (tar->type == PORT_TYPE_ATOM)
+			&& (tar->atom.buffer_type == PORT_BUFFER_TYPE_SEQUENCE)
+			&& (tar->direction == PORT_DIRECTION_OUTPUT)
+			&& !mod->system_ports // don't overwrite source buffer events
+			&& (i != mod->num_ports - 4) // ignore dsp debug port
+			&& (i != mod->num_ports - 3) ) // ignore ui debug port
+		{
+			mod->seq_ports[mod->num_seq_ins + mod->num_seq_outs++] = i;
+		}
+	}
+
+	return 0;
+}
+
+// allocate buffers to keep last period's outputs for pipelined mode
+static inline void
+_sp_app_mod_delay_alloc(sp_app_t *app, mod_t *mod)
+{
+	_sp_app_mod_free_pool(&mod->delay);
+
+	for(unsigned i=0; i<mod->num_ports; i++)
+		mod->ports[i].delay = NULL;
+
+	if(!app->pipelined)
+		return;
+
+	mod->delay.size = 0;
+	for(unsigned i=0; i<mod->num_ports - 4; i++) // - automation/debug ports
+	{
+		port_t *tar = &mod->ports[i];
+
+		if( (tar->direction == PORT_DIRECTION_OUTPUT) && (tar->type != PORT_TYPE_CONTROL) )
+			mod->delay.size += _port_pad_size(tar->type, tar->size);
+	}
+
+	if(!mod->delay.size || _sp_app_mod_alloc_pool(&mod->delay))
+		return; // runs without delay, e.g. in a single stage
+
+	void *ptr = mod->delay.buf;
+	for(unsigned i=0; i<mod->num_ports - 4; i++)
+	{
+		port_t *tar = &mod->ports[i];
+
+		if( (tar->direction == PORT_DIRECTION_OUTPUT) && (tar->type != PORT_TYPE_CONTROL) )
+		{
+			tar->delay = ptr;
+			ptr += _port_pad_size(tar->type, tar->size);
 		}
 	}
 }
@@ -245,7 +551,7 @@ _sp_app_mod_reinitialize(mod_t *mod)
 			|| (tar->type == PORT_TYPE_CV) )
 		{
 			tar->size = app->driver->max_block_size * sizeof(float);
-			mod->pools[tar->type].size += lv2_atom_pad_size(tar->size);
+			mod->pools[tar->type].size += _port_pad_size(tar->type, tar->size);
 		}
 	}
 	
@@ -254,6 +560,8 @@ _sp_app_mod_reinitialize(mod_t *mod)
 
 	_sp_app_mod_slice_pool(mod, PORT_TYPE_AUDIO);
 	_sp_app_mod_slice_pool(mod, PORT_TYPE_CV);
+
+	_sp_app_mod_delay_alloc(app, mod);
 }
 
 static inline int 
@@ -619,7 +927,6 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 
 	mod->needs_bypassing = false; // plugins with control ports only need no bypassing upon preset load
 	mod->bypassed = false;
-	atomic_init(&mod->dsp_client.ref_count, 0);
 
 	// populate worker schedule
 	mod->worker.schedule.handle = mod;
@@ -905,7 +1212,7 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 		}
 
 		// increase pool sizes
-		mod->pools[tar->type].size += lv2_atom_pad_size(tar->size);
+		mod->pools[tar->type].size += _port_pad_size(tar->type, tar->size);
 	}
 
 	// rough guestimate of minimal debug port size
@@ -934,7 +1241,7 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 		tar->sys.data = NULL;
 
 		// increase pool sizes
-		mod->pools[tar->type].size += lv2_atom_pad_size(tar->size);
+		mod->pools[tar->type].size += _port_pad_size(tar->type, tar->size);
 	}
 
 	// debug ui port //FIXME check
@@ -958,7 +1265,7 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 		tar->sys.data = NULL;
 
 		// increase pool sizes
-		mod->pools[tar->type].size += lv2_atom_pad_size(tar->size);
+		mod->pools[tar->type].size += _port_pad_size(tar->type, tar->size);
 	}
 
 	// automation input port //FIXME check
@@ -982,7 +1289,7 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 		tar->sys.data = NULL;
 
 		// increase pool sizes
-		mod->pools[tar->type].size += lv2_atom_pad_size(tar->size);
+		mod->pools[tar->type].size += _port_pad_size(tar->type, tar->size);
 	}
 
 	// automation output port //FIXME check
@@ -1006,10 +1313,10 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 		tar->sys.data = NULL;
 
 		// increase pool sizes
-		mod->pools[tar->type].size += lv2_atom_pad_size(tar->size);
+		mod->pools[tar->type].size += _port_pad_size(tar->type, tar->size);
 	}
 
-	// allocate 8-byte aligned buffer per plugin and port type pool
+	// allocate cache line aligned buffer per plugin and port type pool
 	int alloc_failed = 0;
 	for(port_type_t pool=0; pool<PORT_TYPE_NUM; pool++)
 	{
@@ -1039,12 +1346,33 @@ _sp_app_mod_add(sp_app_t *app, const char *uri, LV2_URID urn, uint32_t created,
 	for(port_type_t pool=0; pool<PORT_TYPE_NUM; pool++)
 		_sp_app_mod_slice_pool(mod, pool);
 
+	_sp_app_mod_delay_alloc(app, mod);
+
+	if(  _sp_app_mod_ctrl_init(mod) || _sp_app_mod_seq_ports_init(mod)
+		|| _sp_app_mod_auto_events_init(mod) )
+	{
+		sp_app_log_error(app, "%s: sequence port list allocation failed\n", __func__);
+
+		for(port_type_t pool=0; pool<PORT_TYPE_NUM; pool++)
+			_sp_app_mod_free_pool(&mod->pools[pool]);
+		_sp_app_mod_free_pool(&mod->delay);
+
+		free(mod->ctrl.dirty);
+		free(mod->seq_ports);
+		free(mod->uri_str);
+		free(mod->ports);
+		free(mod);
+
+		return NULL;
+	}
+
 	for(unsigned i=0; i<mod->num_ports - 4; i++)
 	{
 		port_t *tar = &mod->ports[i];
 
 		// set port buffer
 		lilv_instance_connect_port(mod->inst, i, tar->base);
+		tar->alias = NULL;
 	}
 
 	// load presets
@@ -1107,6 +1435,7 @@ _sp_app_mod_del(sp_app_t *app, mod_t *mod)
 	// free memory
 	for(port_type_t pool=0; pool<PORT_TYPE_NUM; pool++)
 		_sp_app_mod_free_pool(&mod->pools[pool]);
+	_sp_app_mod_free_pool(&mod->delay);
 
 	// unregister system ports
 	for(unsigned i=0; i<mod->num_ports; i++)
@@ -1117,9 +1446,21 @@ _sp_app_mod_del(sp_app_t *app, mod_t *mod)
 			app->driver->system_port_del(app->data, port->sys.data);
 	}
 
+	free(mod->ctrl.dirty); // holds all control arrays
+	free(mod->seq_ports);
+	free(mod->auto_events);
+
 	// free ports
 	if(mod->ports)
 	{
+		for(unsigned i=0; i<mod->num_ports; i++)
+		{
+			connectable_t *conn = _sp_app_port_connectable(&mod->ports[i]);
+
+			if(conn)
+				free(conn->sources);
+		}
+
 		free(mod->ports);
 	}
 
@@ -1131,6 +1472,22 @@ _sp_app_mod_del(sp_app_t *app, mod_t *mod)
 	return 0; //success
 }
 
+// grow module table in place, only while worker owns the graph
+__non_realtime int
+_sp_app_mod_table_grow(sp_app_t *app)
+{
+	const unsigned max_mods = app->max_mods << 1;
+
+	mod_t **mods = realloc(app->mods, max_mods * sizeof(mod_t *));
+	if(!mods)
+		return -1;
+
+	app->mods = mods;
+	app->max_mods = max_mods;
+
+	return 0;
+}
+
 mod_t *
 _sp_app_mod_get_by_uid(sp_app_t *app, int32_t uid)
 {
@@ -1148,17 +1505,7 @@ _sp_app_mod_get_by_uid(sp_app_t *app, int32_t uid)
 void
 _sp_app_mod_eject(sp_app_t *app, mod_t *mod)
 {
-	// eject module from graph
-	app->num_mods -= 1;
-	// remove mod from ->mods
-	for(unsigned m=0, offset=0; m<app->num_mods; m++)
-	{
-		if(app->mods[m] == mod)
-			offset += 1;
-		app->mods[m] = app->mods[m+offset];
-	}
-
-	// disconnect all ports
+	// disconnect all ports while module is still part of graph
 	for(unsigned p1=0; p1<mod->num_ports; p1++)
 	{
 		port_t *port = &mod->ports[p1];
@@ -1166,9 +1513,9 @@ _sp_app_mod_eject(sp_app_t *app, mod_t *mod)
 		connectable_t *conn = _sp_app_port_connectable(port);
 		if(conn)
 		{
-			// disconnect sources
-			for(int s=0; s<conn->num_sources; s++)
-				_sp_app_port_disconnect(app, conn->sources[s].port, port);
+			// disconnect sources, list shrinks with each disconnection
+			while(conn->num_sources > 0)
+				_sp_app_port_disconnect(app, conn->sources[0].port, port);
 		}
 
 		// disconnect sinks
@@ -1179,6 +1526,19 @@ _sp_app_mod_eject(sp_app_t *app, mod_t *mod)
 		}
 	}
 
+	// eject module from graph
+	app->num_mods -= 1;
+	// remove mod from ->mods
+	for(unsigned m=0, offset=0; m<app->num_mods; m++)
+	{
+		if(app->mods[m] == mod)
+			offset += 1;
+		app->mods[m] = app->mods[m+offset];
+	}
+
+	_sp_app_order(app); // before module is freed by worker
+	_sp_app_port_control_unstash(app, mod);
+
 	// send request to worker thread
 	size_t size = sizeof(job_t);
 	job_t *job = _sp_app_to_worker_request(app, size);
@@ -1193,8 +1553,6 @@ _sp_app_mod_eject(sp_app_t *app, mod_t *mod)
 		sp_app_log_error(app, "%s: failed requesting buffer\n", __func__);
 	}
 
-	_sp_app_order(app);
-
 #if 0
 	// signal to ui
 	size = sizeof(transmit_module_del_t);
@@ -1230,6 +1588,7 @@ _sp_app_mod_reinitialize_soft(mod_t *mod)
 
 		// set port buffer
 		lilv_instance_connect_port(mod->inst, i, tar->base);
+		tar->alias = NULL;
 	}
 }
 
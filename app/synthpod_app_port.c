@@ -23,20 +23,18 @@
 #include <osc.lv2/util.h>
 
 #if !defined(USE_DYNAMIC_PARALLELIZER)
-__realtime static inline void
-_dsp_master_concurrent(sp_app_t *app)
+__non_realtime static inline void
+_dsp_plan_concurrent(dsp_master_t *dsp_master, dsp_plan_t *plan)
 {
-	dsp_master_t *dsp_master = &app->dsp_master;
+	int *counts = dsp_master->counts;
+	unsigned *marks = dsp_master->stamps;
 
-	dsp_master->concurrent = 0;
+	plan->concurrent = 0;
 
-	for(unsigned m=0; m<app->num_mods; m++)
+	for(unsigned i=0; i<plan->num_nodes; i++)
 	{
-		mod_t *mod = app->mods[m];
-		dsp_client_t *dsp_client = &mod->dsp_client;
-
-		dsp_client->count = dsp_client->num_sources;
-		dsp_client->mark = 0;
+		counts[i] = plan->num_sources[i];
+		marks[i] = 0;
 	}
 
 	while(true)
@@ -44,304 +42,1124 @@ _dsp_master_concurrent(sp_app_t *app)
 		bool done = true;
 		unsigned sum = 0;
 
-		for(unsigned m=0; m<app->num_mods; m++)
+		for(unsigned i=0; i<plan->num_nodes; i++)
 		{
-			mod_t *mod = app->mods[m];
-			dsp_client_t *dsp_client = &mod->dsp_client;
-
-			const int count = dsp_client->count;
+			const int count = counts[i];
 			if(count == 0)
 				sum += 1;
 			else if(count > 0)
 				done = false;
 		}
 
-		//printf("sum: %u, concurrent: %u\n", sum, dsp_master->concurrent);
-		if(sum > dsp_master->concurrent)
-			dsp_master->concurrent = sum;
+		//printf("sum: %u, concurrent: %u\n", sum, plan->concurrent);
+		if(sum > plan->concurrent)
+			plan->concurrent = sum;
 
 		if(done)
 			break;
 
-		for(unsigned m=0; m<app->num_mods; m++)
+		for(unsigned i=0; i<plan->num_nodes; i++)
 		{
-			mod_t *mod = app->mods[m];
-			dsp_client_t *dsp_client = &mod->dsp_client;
-
-			if(dsp_client->count == 0)
+			if(counts[i] == 0)
 			{
-				dsp_client->mark += 1;
-
-				for(unsigned j=0; j<dsp_client->num_sinks; j++)
-				{
-					dsp_client_t *sink = dsp_client->sinks[j];
+				marks[i] += 1;
 
-					sink->mark += 1;
-				}
+				for(unsigned j=plan->sinks_offset[i]; j<plan->sinks_offset[i+1]; j++)
+					marks[plan->sinks[j]] += 1;
 			}
 		}
 
-		for(unsigned m=0; m<app->num_mods; m++)
+		for(unsigned i=0; i<plan->num_nodes; i++)
 		{
-			mod_t *mod = app->mods[m];
-			dsp_client_t *dsp_client = &mod->dsp_client;
-
-			if(dsp_client->mark > 0)
+			if(marks[i] > 0)
 			{
-				dsp_client->count -= dsp_client->mark;
-				dsp_client->mark = 0;
+				counts[i] -= marks[i];
+				marks[i] = 0;
 			}
 		}
 	}
 
-	//printf("concurrent: %u\n", dsp_master->concurrent);
+	//printf("concurrent: %u\n", plan->concurrent);
 }
 #endif
 
+#if defined(USE_DYNAMIC_PARALLELIZER)
+// insertion sort node list by rank, ascending or descending
+static inline void
+_dsp_plan_sort(const dsp_plan_t *plan, unsigned *nodes, unsigned num, bool ascending)
+{
+	for(unsigned i=1; i<num; i++)
+	{
+		const unsigned node = nodes[i];
+		const unsigned rank = plan->ranks[node];
+		unsigned j = i;
+
+		for( ; j>0; j--)
+		{
+			const unsigned other = plan->ranks[nodes[j-1]];
+
+			if(ascending ? (other <= rank) : (other >= rank))
+				break;
+
+			nodes[j] = nodes[j-1];
+		}
+
+		nodes[j] = node;
+	}
+}
+
+// order roots by descending rank and sink lists by ascending rank, sinks are
+// pushed onto the deque in order, thus the one with the longest remaining path
+// ends up at the bottom and is run next
 __realtime void
-_dsp_master_reorder(sp_app_t *app)
+_dsp_plan_prioritize(dsp_plan_t *plan)
 {
-	for(unsigned m=0; m<app->num_mods; m++)
+	_dsp_plan_sort(plan, plan->roots, plan->num_roots, false);
+
+	for(unsigned i=0; i<plan->num_nodes; i++)
 	{
-		mod_t *mod = app->mods[m];
-		dsp_client_t *dsp_client = &mod->dsp_client;
+		const unsigned offset = plan->sinks_offset[i];
+
+		_dsp_plan_sort(plan, &plan->sinks[offset], plan->sinks_offset[i+1] - offset, true);
+	}
+}
+#endif
+
+// reserve region in trailing data of graph, plan or scratch, only measures
+// needed size while data is NULL
+static inline void *
+_dsp_region(uint64_t *data, size_t *words, size_t size)
+{
+	void *region = data ? &data[*words] : NULL;
+
+	*words += (size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	return region;
+}
+
+__non_realtime static size_t
+_dsp_graph_layout(dsp_graph_t *graph, uint64_t *data, unsigned max_nodes,
+	unsigned max_edges)
+{
+	size_t words = 0;
+
+	graph->mods = _dsp_region(data, &words, max_nodes * sizeof(mod_t *));
+	graph->delayable = _dsp_region(data, &words, max_nodes * sizeof(bool));
+	graph->poolable = _dsp_region(data, &words, max_nodes * sizeof(bool));
+#if defined(USE_DYNAMIC_PARALLELIZER)
+	graph->ranks = _dsp_region(data, &words, max_nodes * sizeof(unsigned));
+#endif
+	graph->sources_offset = _dsp_region(data, &words, (max_nodes + 1) * sizeof(unsigned));
+	graph->sources = _dsp_region(data, &words, max_edges * sizeof(unsigned));
+
+	return words;
+}
+
+__non_realtime dsp_graph_t *
+_dsp_graph_new(unsigned max_nodes, unsigned max_edges)
+{
+	dsp_graph_t dummy;
+	const size_t words = _dsp_graph_layout(&dummy, NULL, max_nodes, max_edges);
+
+	dsp_graph_t *graph = calloc(1, sizeof(dsp_graph_t) + words*sizeof(uint64_t));
+	if(!graph)
+		return NULL;
+
+	_dsp_graph_layout(graph, graph->data, max_nodes, max_edges);
+	graph->max_nodes = max_nodes;
+	graph->max_edges = max_edges;
+
+	return graph;
+}
+
+__realtime static void
+_dsp_master_graph_grow(sp_app_t *app, unsigned num_nodes, unsigned num_edges)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+
+	if(dsp_master->graph_pending)
+		return; // already waiting for worker
+
+	unsigned max_nodes = dsp_master->graph->max_nodes;
+	while(max_nodes < num_nodes)
+		max_nodes <<= 1;
+
+	unsigned max_edges = dsp_master->graph->max_edges;
+	while(max_edges < num_edges)
+		max_edges <<= 1;
+
+	// signal to worker
+	job_t *job = _sp_app_to_worker_request(app, sizeof(job_t));
+	if(job)
+	{
+		job->request = JOB_TYPE_REQUEST_GRAPH_ALLOC;
+		job->max_nodes = max_nodes;
+		job->max_edges = max_edges;
+		_sp_app_to_worker_advance(app, sizeof(job_t));
+
+		dsp_master->graph_pending = true;
+	}
+	else
+	{
+		sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+	}
+}
+
+// take snapshot of graph and have worker compile it, as the graph may be
+// changed repeatedly within a period, this is done once at its end
+__realtime void
+_dsp_master_snapshot(sp_app_t *app)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+	dsp_graph_t *graph = dsp_master->graph;
 
-		dsp_client->num_sinks = 0;
-		dsp_client->num_sources = 0;
+	if(!dsp_master->stale || dsp_master->plan_pending || dsp_master->graph_pending)
+		return; // nothing to do or worker still busy with graph
+
+	if(app->num_mods > graph->max_nodes)
+	{
+		_dsp_master_graph_grow(app, app->num_mods, graph->max_edges);
+		return; // try again with grown graph
 	}
 
 	for(unsigned m=0; m<app->num_mods; m++)
 	{
-		mod_t *mod_sink = app->mods[m];
+		mod_t *mod = app->mods[m];
+
+		mod->dsp_client.node = m;
+		graph->mods[m] = mod;
+		graph->delayable[m] = mod->delay.buf != NULL;
+		graph->poolable[m] = !mod->system_ports; // driver accesses buffers directly
+#if defined(USE_DYNAMIC_PARALLELIZER)
+		graph->ranks[m] = mod->dsp_client.rank;
+#endif
 
-		for(unsigned n=0; n<m; n++)
+		for(unsigned p=0; p<mod->num_ports - 4; p++)
 		{
-			mod_t *mod_source = app->mods[n];
-			bool is_connected = false;
+			const port_t *port = &mod->ports[p];
 
-			for(unsigned p=0; p<mod_sink->num_ports; p++)
+			if(  port->subscriptions
+				&& ( (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV) ) )
 			{
-				port_t *port_sink = &mod_sink->ports[p];
+				graph->poolable[m] = false; // is read after all modules have run
+			}
+		}
+	}
 
-				connectable_t *conn = _sp_app_port_connectable(port_sink);
-				if(conn)
-				{
-					for(int s=0; s<conn->num_sources; s++)
-					{
-						source_t *source =  &conn->sources[s];
+	unsigned num_edges = 0; // including those not fitting into graph
+	for(unsigned m=0; m<app->num_mods; m++)
+	{
+		mod_t *mod = app->mods[m];
 
-						if(source->port->mod == mod_source)
-						{
-							is_connected = true;
-							break;
-						}
-					}
-				}
+		graph->sources_offset[m] = num_edges;
 
-				if(is_connected)
-				{
-					break;
-				}
-			}
+		for(unsigned p=0; p<mod->num_ports; p++)
+		{
+			connectable_t *conn = _sp_app_port_connectable(&mod->ports[p]);
+			if(!conn)
+				continue; // skip
 
-			if(is_connected)
+			for(int s=0; s<conn->num_sources; s++)
 			{
-				mod_source->dsp_client.sinks[mod_source->dsp_client.num_sinks] = &mod_sink->dsp_client;
-				mod_source->dsp_client.num_sinks += 1;
-				mod_sink->dsp_client.num_sources += 1;
-
-				//printf("%u -> %u\n", mod_source->uid, mod_sink->uid);
+				if(num_edges < graph->max_edges)
+					graph->sources[num_edges] = conn->sources[s].port->mod->dsp_client.node;
+				num_edges += 1;
 			}
 		}
 	}
+	graph->sources_offset[app->num_mods] = num_edges;
 
-	/*
-	for(unsigned m=0; m<app->num_mods; m++)
+	if(num_edges > graph->max_edges)
 	{
-		mod_t *mod = app->mods[m];
-		sp_app_log_trace(app, "%s: %u, %u\n",
-			app->driver->unmap->unmap(app->driver->unmap->handle, mod->plug_urid),
-			mod->dsp_client.num_sources, mod->dsp_client.num_sinks);
+		sp_app_log_trace(app, "%s: too many connections, running serially\n", __func__);
+
+		_dsp_master_graph_grow(app, app->num_mods, num_edges);
+		return; // try again with grown graph
 	}
-	sp_app_log_trace(app, "\n");
-	*/
 
-#if !defined(USE_DYNAMIC_PARALLELIZER)
-	_dsp_master_concurrent(app);
+	graph->version = dsp_master->version;
+	graph->num_nodes = app->num_mods;
 
-	// to nk
-	LV2_Atom *answer = _sp_app_to_ui_request_atom(app);
-	if(answer)
+	// signal to worker
+	job_t *job = _sp_app_to_worker_request(app, sizeof(job_t));
+	if(job)
 	{
-		const int32_t cpus_used = (app->dsp_master.concurrent > app->dsp_master.num_slaves + 1)
-			? app->dsp_master.num_slaves + 1
-			: app->dsp_master.concurrent;
+		job->request = JOB_TYPE_REQUEST_PLAN_COMPILE;
+		job->graph = graph;
+		_sp_app_to_worker_advance(app, sizeof(job_t));
 
-		LV2_Atom_Forge_Ref ref = synthpod_patcher_set(
-			&app->regs, &app->forge, 0, 0, app->regs.synthpod.cpus_used.urid,
-			sizeof(int32_t), app->forge.Int, &cpus_used); //TODO subj, seqn
-		if(ref)
-		{
-			_sp_app_to_ui_advance_atom(app, answer);
-		}
-		else
-		{
-			_sp_app_to_ui_overflow(app);
-		}
+		dsp_master->stale = false;
+		dsp_master->plan_pending = true;
 	}
 	else
 	{
-		_sp_app_to_ui_overflow(app);
+		sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
 	}
+}
+
+__non_realtime static size_t
+_dsp_plan_layout(dsp_plan_t *plan, uint64_t *data, unsigned num_nodes,
+	unsigned max_edges, unsigned num_threads)
+{
+	size_t words = 0;
+
+	plan->mods = _dsp_region(data, &words, num_nodes * sizeof(mod_t *));
+	plan->stages = _dsp_region(data, &words, num_nodes * sizeof(unsigned));
+	plan->roots = _dsp_region(data, &words, num_nodes * sizeof(unsigned));
+	plan->num_sources = _dsp_region(data, &words, num_nodes * sizeof(unsigned));
+	plan->chain = _dsp_region(data, &words, num_nodes * sizeof(int));
+#if defined(USE_DYNAMIC_PARALLELIZER)
+	plan->ranks = _dsp_region(data, &words, num_nodes * sizeof(unsigned));
 #endif
+	plan->delayed = _dsp_region(data, &words, num_nodes * sizeof(unsigned));
+	plan->sources_offset = _dsp_region(data, &words, (num_nodes + 1) * sizeof(unsigned));
+	plan->sources = _dsp_region(data, &words, max_edges * sizeof(unsigned));
+	plan->sinks_offset = _dsp_region(data, &words, (num_nodes + 1) * sizeof(unsigned));
+	plan->sinks = _dsp_region(data, &words, max_edges * sizeof(unsigned));
+	plan->ref_counts = _dsp_region(data, &words, num_nodes * sizeof(atomic_int));
+	plan->queues = _dsp_region(data, &words, num_threads * num_nodes * sizeof(atomic_uint));
+
+	return words;
 }
 
-bool
-_sp_app_port_connected(port_t *src_port, port_t *snk_port, float gain)
+__non_realtime static size_t
+_dsp_scratch_layout(dsp_master_t *dsp_master, uint64_t *data, unsigned max_nodes)
 {
-	connectable_t *conn = _sp_app_port_connectable(snk_port);
-	if(conn)
-	{
-		for(int s = 0; s < conn->num_sources; s++)
-		{
-			source_t *src = &conn->sources[s];
+	size_t words = 0;
+
+	dsp_master->words = (max_nodes + 63) / 64;
+	dsp_master->marks = _dsp_region(data, &words, max_nodes * sizeof(order_mark_t));
+	dsp_master->order = _dsp_region(data, &words, max_nodes * sizeof(unsigned));
+	dsp_master->position = _dsp_region(data, &words, max_nodes * sizeof(unsigned));
+	dsp_master->stamps = _dsp_region(data, &words, max_nodes * sizeof(unsigned));
+	dsp_master->levels = _dsp_region(data, &words, max_nodes * sizeof(unsigned));
+	dsp_master->flags = _dsp_region(data, &words, max_nodes * sizeof(bool));
+	dsp_master->pool_out = _dsp_region(data, &words, max_nodes * sizeof(bool));
+	dsp_master->ancestors = _dsp_region(data, &words,
+		max_nodes * dsp_master->words * sizeof(uint64_t));
+	dsp_master->readers = _dsp_region(data, &words,
+		max_nodes * dsp_master->words * sizeof(uint64_t));
+#if !defined(USE_DYNAMIC_PARALLELIZER)
+	dsp_master->counts = _dsp_region(data, &words, max_nodes * sizeof(int));
+#endif
 
-			if(src->port == src_port)
-			{
-				src->gain = gain;
-				return true;
-			}
-		}
-	}
+	return words;
+}
 
-	return false;
+// grow scratch for plan compilation along with graph, worker only
+__non_realtime static bool
+_dsp_master_scratch_grow(dsp_master_t *dsp_master, unsigned max_nodes)
+{
+	if(max_nodes <= dsp_master->max_scratch)
+		return true; // big enough
+
+	free(dsp_master->scratch);
+	dsp_master->max_scratch = 0;
+
+	const size_t words = _dsp_scratch_layout(dsp_master, NULL, max_nodes);
+
+	dsp_master->scratch = calloc(words, sizeof(uint64_t));
+	if(!dsp_master->scratch)
+		return false;
+
+	_dsp_scratch_layout(dsp_master, dsp_master->scratch, max_nodes);
+	dsp_master->max_scratch = max_nodes;
+
+	return true;
 }
 
-int
-_sp_app_port_connect(sp_app_t *app, port_t *src_port, port_t *snk_port, float gain)
+// visit all nodes feeding into given node before appending node itself
+__non_realtime static void
+_dsp_graph_visit(dsp_master_t *dsp_master, const dsp_graph_t *graph, unsigned n,
+	unsigned *num_ordered, unsigned *num_feedbacks)
 {
-	if(_sp_app_port_connected(src_port, snk_port, gain))
-		return 0;
+	if(dsp_master->marks[n] == ORDER_MARK_DONE)
+		return; // already ordered
 
-	connectable_t *conn = _sp_app_port_connectable(snk_port);
-	if(!conn)
+	if(dsp_master->marks[n] == ORDER_MARK_BUSY)
 	{
-		sp_app_log_trace(app, "%s: invalid connectable\n", __func__);
-		return 0;
+		*num_feedbacks += 1; // connection closes a cycle
+		return;
 	}
 
-	if(conn->num_sources >= MAX_SOURCES)
-	{
-		sp_app_log_trace(app, "%s: too many sources\n", __func__);
-		return 0;
-	}
+	dsp_master->marks[n] = ORDER_MARK_BUSY;
 
-	source_t *source = &conn->sources[conn->num_sources];
-	source->port = src_port;;
-	source->gain = gain;
-	conn->num_sources += 1;
+	for(unsigned j=graph->sources_offset[n]; j<graph->sources_offset[n+1]; j++)
+		_dsp_graph_visit(dsp_master, graph, graph->sources[j], num_ordered, num_feedbacks);
 
-	// only audio port connections need to be ramped to be clickless
-	if(snk_port->type == PORT_TYPE_AUDIO)
-	{
-		source->ramp.samples = app->ramp_samples;
-		source->ramp.state = RAMP_STATE_UP;
-		source->ramp.value = 0.f;
-	}
+	dsp_master->marks[n] = ORDER_MARK_DONE;
 
-	_dsp_master_reorder(app);
-	return 1;
+	dsp_master->position[n] = *num_ordered;
+	dsp_master->order[*num_ordered] = n;
+	*num_ordered += 1;
 }
 
-void
-_sp_app_port_disconnect(sp_app_t *app, port_t *src_port, port_t *snk_port)
+// split plan into two pipeline stages at half of its depth, roots always go
+// to first and leaves to second stage, so every path crosses stages once
+__non_realtime static void
+_dsp_plan_split(dsp_master_t *dsp_master, const dsp_graph_t *graph, dsp_plan_t *plan)
 {
-	connectable_t *conn = _sp_app_port_connectable(snk_port);
-	if(!conn)
-		return;
+	unsigned max_level = 0;
 
-	// update sources list 
-	bool connected = false;
-	for(int i=0, j=0; i<conn->num_sources; i++)
+	for(unsigned m=0; m<plan->num_nodes; m++)
 	{
-		if(conn->sources[i].port == src_port)
+		dsp_master->levels[m] = 0;
+		dsp_master->flags[m] = false;
+	}
+
+	// derive longest path from any root in number of modules
+	for(unsigned m=0; m<plan->num_nodes; m++)
+	{
+		const unsigned g = dsp_master->order[m];
+
+		for(unsigned j=graph->sources_offset[g]; j<graph->sources_offset[g+1]; j++)
 		{
-			connected = true;
-			continue;
+			const unsigned n = dsp_master->position[graph->sources[j]];
+
+			if(n >= m)
+				continue; // feedback
+
+			dsp_master->flags[n] = true;
+
+			if(dsp_master->levels[n] + 1 > dsp_master->levels[m])
+				dsp_master->levels[m] = dsp_master->levels[n] + 1;
 		}
 
-		conn->sources[j++].port = conn->sources[i].port;
+		if(dsp_master->levels[m] > max_level)
+			max_level = dsp_master->levels[m];
 	}
 
-	if(!connected)
-		return;
+	for(unsigned m=0; m<plan->num_nodes; m++)
+	{
+		const unsigned level = dsp_master->levels[m];
 
-	conn->num_sources -= 1;
+		if(level == 0)
+			plan->stages[m] = 0; // root
+		else if(!dsp_master->flags[m])
+			plan->stages[m] = 1; // leaf
+		else
+			plan->stages[m] = (2*level > max_level) ? 1 : 0;
+	}
+}
 
-	_dsp_master_reorder(app);
+// bit set row of given node
+static inline uint64_t *
+_bits_row(uint64_t *bits, unsigned words, unsigned n)
+{
+	return &bits[n * words];
 }
 
-int
-_sp_app_port_disconnect_request(sp_app_t *app, port_t *src_port, port_t *snk_port,
-	ramp_state_t ramp_state)
+__non_realtime static inline void
+_bits_set(uint64_t *bits, unsigned n)
 {
-	if(  (src_port->direction == PORT_DIRECTION_OUTPUT)
-		&& (snk_port->direction == PORT_DIRECTION_INPUT) )
+	bits[n / 64] |= UINT64_C(1) << (n % 64);
+}
+
+__non_realtime static inline bool
+_bits_get(const uint64_t *bits, unsigned n)
+{
+	return bits[n / 64] & (UINT64_C(1) << (n % 64));
+}
+
+// whether a is a subset of b
+__non_realtime static inline bool
+_bits_subset(const uint64_t *a, const uint64_t *b, unsigned words)
+{
+	for(unsigned w=0; w<words; w++)
 	{
-		source_t *source = NULL;
+		if(a[w] & ~b[w])
+			return false;
+	}
 
-		connectable_t *conn = _sp_app_port_connectable(snk_port);
-		if(conn)
+	return true;
+}
+
+__non_realtime static inline bool
+_port_poolable(const port_t *port)
+{
+	return (port->type == PORT_TYPE_AUDIO) || (port->type == PORT_TYPE_CV);
+}
+
+// share audio and CV buffers among ports of different nodes, a buffer is
+// handed on to a node only when its previous owner and all readers of it are
+// ancestors of that node, e.g. have finished in any schedule
+__non_realtime static void
+_dsp_plan_pool(sp_app_t *app, const dsp_graph_t *graph, dsp_plan_t *plan)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+	const size_t stride = _port_pad_size(PORT_TYPE_AUDIO, app->driver->max_block_size * sizeof(float));
+	const unsigned words = dsp_master->words;
+	uint64_t *ancestors = dsp_master->ancestors;
+	uint64_t *readers = dsp_master->readers;
+
+	// derive ancestors from dependencies and readers from all connections
+	memset(ancestors, 0x0, plan->num_nodes * words * sizeof(uint64_t));
+	memset(readers, 0x0, plan->num_nodes * words * sizeof(uint64_t));
+
+	for(unsigned m=0; m<plan->num_nodes; m++)
+	{
+		const unsigned g = dsp_master->order[m];
+		uint64_t *row = _bits_row(ancestors, words, m);
+
+		for(unsigned j=plan->sources_offset[m]; j<plan->sources_offset[m+1]; j++)
 		{
-			// find connection
-			for(int i=0; i<conn->num_sources; i++)
-			{
-				if(conn->sources[i].port == src_port)
-				{
-					source = &conn->sources[i];
-					break;
-				}
-			}
+			const unsigned n = plan->sources[j];
+			const uint64_t *src = _bits_row(ancestors, words, n);
+
+			for(unsigned w=0; w<words; w++)
+				row[w] |= src[w];
+			_bits_set(row, n);
 		}
 
-		if(source)
+		for(unsigned j=graph->sources_offset[g]; j<graph->sources_offset[g+1]; j++)
+			_bits_set(_bits_row(readers, words, dsp_master->position[graph->sources[j]]), m);
+	}
+
+	// outputs read one period behind or by feedback connections stay private
+	unsigned num_bindings = 0;
+	for(unsigned m=0; m<plan->num_nodes; m++)
+	{
+		const mod_t *mod = plan->mods[m];
+
+		dsp_master->pool_out[m] = !dsp_master->flags[m];
+
+		for(unsigned r=0; r<plan->num_nodes; r++)
 		{
-			if(src_port->type == PORT_TYPE_AUDIO)
+			if(  _bits_get(_bits_row(readers, words, m), r)
+				&& !_bits_get(_bits_row(ancestors, words, r), m) )
 			{
-				// only audio output ports need to be ramped to be clickless
+				dsp_master->pool_out[m] = false;
+			}
+		}
 
-				if(source->ramp.state == RAMP_STATE_NONE)
-				{
-					source->ramp.samples = app->ramp_samples;
-					source->ramp.state = ramp_state;
-					source->ramp.value = 1.f;
-				}
+		if(!graph->poolable[dsp_master->order[m]])
+			continue; // skip
 
-				return 1; // needs ramping
-			}
-			else // !AUDIO
+		for(unsigned p=0; p<mod->num_ports - 4; p++) // ignore debug and automation ports
+		{
+			const port_t *port = &mod->ports[p];
+
+			if(  _port_poolable(port)
+				&& ( (port->direction == PORT_DIRECTION_INPUT) || dsp_master->pool_out[m] ) )
 			{
-				// disconnect immediately
-				_sp_app_port_disconnect(app, src_port, snk_port);
+				num_bindings += 1;
 			}
 		}
 	}
 
-	return 0; // not connected
-}
+	if(num_bindings == 0)
+		return;
 
-int
-_sp_app_port_desilence(sp_app_t *app, port_t *src_port, port_t *snk_port)
-{
-	if(  (src_port->direction == PORT_DIRECTION_OUTPUT)
-		&& (snk_port->direction == PORT_DIRECTION_INPUT) )
+	plan->bindings = calloc(num_bindings, sizeof(dsp_binding_t));
+	unsigned *indices = calloc(num_bindings, sizeof(unsigned)); // buffer per binding
+	unsigned *owners = calloc(num_bindings, sizeof(unsigned)); // node per buffer
+	bool *outputs = calloc(num_bindings, sizeof(bool)); // whether owned by output
+	if(!plan->bindings || !indices || !owners || !outputs)
+		goto fail;
+
+	// assign buffers greedily in topological order
+	for(unsigned m=0; m<plan->num_nodes; m++)
 	{
-		source_t *source = NULL;
+		mod_t *mod = plan->mods[m];
 
-		connectable_t *conn = _sp_app_port_connectable(snk_port);
-		if(conn)
+		if(!graph->poolable[dsp_master->order[m]])
+			continue; // skip
+
+		for(unsigned p=0; p<mod->num_ports - 4; p++) // ignore debug and automation ports
 		{
-			// find connection
+			port_t *port = &mod->ports[p];
+			const bool output = port->direction == PORT_DIRECTION_OUTPUT;
+
+			if(!_port_poolable(port) || (output && !dsp_master->pool_out[m]) )
+				continue; // skip
+
+			unsigned b;
+			for(b=0; b<plan->num_buffers; b++)
+			{
+				const unsigned owner = owners[b];
+
+				const uint64_t *row = _bits_row(ancestors, words, m);
+
+				if(  _bits_get(row, owner)
+					&& ( !outputs[b]
+						|| _bits_subset(_bits_row(readers, words, owner), row, words) ) )
+				{
+					break; // reuse
+				}
+			}
+
+			if(b == plan->num_buffers)
+				plan->num_buffers += 1; // new buffer
+
+			owners[b] = m;
+			outputs[b] = output;
+
+			plan->bindings[plan->num_bindings].port = port;
+			indices[plan->num_bindings] = b;
+			plan->num_bindings += 1;
+		}
+	}
+
+	plan->buffers = aligned_alloc(CACHE_LINE_SIZE, plan->num_buffers * stride);
+	if(!plan->buffers)
+		goto fail;
+
+	memset(plan->buffers, 0x0, plan->num_buffers * stride);
+
+	for(unsigned k=0; k<plan->num_bindings; k++)
+		plan->bindings[k].buf = (uint8_t *)plan->buffers + indices[k]*stride;
+
+	free(indices);
+	free(owners);
+	free(outputs);
+
+	return;
+
+fail:
+	sp_app_log_error(app, "%s: out-of-memory, keeping private buffers\n", __func__);
+
+	free(indices);
+	free(owners);
+	free(outputs);
+	free(plan->bindings);
+	plan->bindings = NULL;
+	plan->num_bindings = 0;
+	plan->num_buffers = 0;
+}
+
+// compile graph snapshot into flat execution plan
+__non_realtime dsp_plan_t *
+_dsp_plan_new(sp_app_t *app, const dsp_graph_t *graph)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+	const unsigned max_edges = graph->sources_offset[graph->num_nodes];
+	const unsigned num_threads = dsp_master->num_slaves + 1;
+
+	if(!_dsp_master_scratch_grow(dsp_master, graph->max_nodes))
+		return NULL;
+
+	dsp_plan_t dummy;
+	const size_t words = _dsp_plan_layout(&dummy, NULL, graph->num_nodes, max_edges,
+		num_threads);
+
+	dsp_plan_t *plan = calloc(1, sizeof(dsp_plan_t) + words*sizeof(uint64_t));
+	if(!plan)
+		return NULL;
+
+	_dsp_plan_layout(plan, plan->data, graph->num_nodes, max_edges, num_threads);
+	plan->version = graph->version;
+	plan->num_nodes = graph->num_nodes;
+
+	// sort topologically, depth-first search keeps previous order for
+	// independent modules, module positions are cosmetic
+	for(unsigned n=0; n<graph->num_nodes; n++)
+		dsp_master->marks[n] = ORDER_MARK_NONE;
+
+	unsigned num_ordered = 0;
+	for(unsigned n=0; n<graph->num_nodes; n++)
+		_dsp_graph_visit(dsp_master, graph, n, &num_ordered, &plan->num_feedbacks);
+	assert(num_ordered == graph->num_nodes);
+
+	for(unsigned m=0; m<plan->num_nodes; m++)
+	{
+		const unsigned g = dsp_master->order[m];
+
+		plan->mods[m] = graph->mods[g];
+#if defined(USE_DYNAMIC_PARALLELIZER)
+		plan->ranks[m] = graph->ranks[g];
+#endif
+		plan->sinks_offset[m] = 0; // used as sink counter first
+		dsp_master->stamps[m] = 0;
+	}
+
+	if(app->pipelined)
+		_dsp_plan_split(dsp_master, graph, plan);
+
+	for(unsigned m=0; m<plan->num_nodes; m++)
+		dsp_master->flags[m] = false; // whether node is delayed
+
+	// gather unique dependencies per node, nodes are sorted topologically,
+	// connections from later to earlier nodes are feedback connections and
+	// thus no dependencies, neither are connections across pipeline stages
+	for(unsigned m=0; m<plan->num_nodes; m++)
+	{
+		const unsigned g = dsp_master->order[m];
+
+		plan->sources_offset[m] = plan->num_edges;
+
+		for(unsigned j=graph->sources_offset[g]; j<graph->sources_offset[g+1]; j++)
+		{
+			const unsigned n = dsp_master->position[graph->sources[j]];
+
+			if( (n >= m) || (dsp_master->stamps[n] == m + 1) )
+				continue; // feedback or already registered
+
+			dsp_master->stamps[n] = m + 1;
+
+			if(  (plan->stages[n] < plan->stages[m])
+				&& graph->delayable[dsp_master->order[n]] )
+			{
+				dsp_master->flags[n] = true;
+				continue; // read one period behind
+			}
+
+			plan->sources[plan->num_edges] = n;
+			plan->num_edges += 1;
+			plan->sinks_offset[n] += 1;
+
+			//printf("%u -> %u\n", n, m);
+		}
+
+		plan->num_sources[m] = plan->num_edges - plan->sources_offset[m];
+
+		if(plan->num_sources[m] == 0)
+		{
+			plan->roots[plan->num_roots] = m;
+			plan->num_roots += 1;
+		}
+	}
+	plan->sources_offset[plan->num_nodes] = plan->num_edges;
+
+	// derive offsets of sink lists from sink counts
+	unsigned offset = 0;
+	for(unsigned i=0; i<plan->num_nodes; i++)
+	{
+		const unsigned num_sinks = plan->sinks_offset[i];
+
+		plan->sinks_offset[i] = offset;
+		dsp_master->stamps[i] = offset; // used as fill position
+		offset += num_sinks;
+	}
+	plan->sinks_offset[plan->num_nodes] = offset;
+
+	// invert dependency lists into sink lists
+	for(unsigned i=0; i<plan->num_nodes; i++)
+	{
+		for(unsigned j=plan->sources_offset[i]; j<plan->sources_offset[i+1]; j++)
+		{
+			const unsigned n = plan->sources[j];
+
+			plan->sinks[dsp_master->stamps[n]] = i;
+			dsp_master->stamps[n] += 1;
+		}
+	}
+
+	// fuse linear chains, a node with a single sink, which itself has no other
+	// source, runs that sink right away on the same thread
+	for(unsigned i=0; i<plan->num_nodes; i++)
+	{
+		const unsigned offset = plan->sinks_offset[i];
+
+		plan->chain[i] = -1;
+
+		if( (plan->sinks_offset[i+1] - offset == 1)
+			&& (plan->num_sources[plan->sinks[offset]] == 1) )
+		{
+			plan->chain[i] = plan->sinks[offset];
+			plan->num_chains += 1;
+		}
+	}
+
+	// list nodes whose outputs are read one period behind
+	for(unsigned i=0; i<plan->num_nodes; i++)
+	{
+		if(!dsp_master->flags[i])
+			continue; // skip
+
+		plan->delayed[plan->num_delayed] = i;
+		plan->num_delayed += 1;
+	}
+
+	_dsp_plan_pool(app, graph, plan);
+
+	/*
+	for(unsigned i=0; i<plan->num_nodes; i++)
+	{
+		mod_t *mod = plan->mods[i];
+		sp_app_log_trace(app, "%s: %u, %u\n",
+			app->driver->unmap->unmap(app->driver->unmap->handle, mod->plug_urid),
+			plan->num_sources[i], plan->sinks_offset[i+1] - plan->sinks_offset[i]);
+	}
+	sp_app_log_trace(app, "\n");
+	*/
+
+#if defined(USE_DYNAMIC_PARALLELIZER)
+	_dsp_plan_prioritize(plan); // with ranks from last measurement
+#else
+	_dsp_plan_concurrent(dsp_master, plan);
+#endif
+
+	return plan;
+}
+
+__non_realtime void
+_dsp_plan_free(dsp_plan_t *plan)
+{
+	free(plan->bindings);
+	free(plan->buffers);
+	free(plan);
+}
+
+// connect ports of bound plan back to their private buffers
+__realtime void
+_dsp_master_unbind(sp_app_t *app)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+	dsp_plan_t *plan = dsp_master->bound;
+
+	if(!plan)
+		return;
+
+	for(unsigned k=0; k<plan->num_bindings; k++)
+	{
+		port_t *port = plan->bindings[k].port;
+
+		port->base = port->priv;
+
+		if(port->direction == PORT_DIRECTION_OUTPUT) // idle modules don't clear private outputs
+			memset(port->base, 0x0, app->driver->max_block_size * sizeof(float));
+
+		if(!port->alias)
+			lilv_instance_connect_port(port->mod->inst, port->index, port->base);
+	}
+
+	dsp_master->bound = NULL;
+}
+
+// swap in plan compiled by worker, unless graph has changed in the meantime
+__realtime void
+_dsp_master_plan_set(sp_app_t *app, dsp_plan_t *plan)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+	dsp_plan_t *old = plan;
+
+	if(app->block_state == BLOCKING_STATE_WAIT)
+	{
+		// graph is owned by worker right now, install once it is released,
+		// a newer plan replaces an older parked one
+		old = dsp_master->parked;
+		dsp_master->parked = plan;
+	}
+	else if(plan && (plan->version == dsp_master->version))
+	{
+		old = atomic_exchange_explicit(&dsp_master->plan, plan, memory_order_acq_rel);
+
+		// hand over last period's outputs of all delayed nodes, as nodes may have
+		// been delayed already in previous plan, or not at all, or with other ports
+		for(unsigned i=0; i<plan->num_delayed; i++)
+			_sp_app_mod_outputs_delay(plan->mods[plan->delayed[i]], app->driver->max_block_size);
+
+		// adopt topological order
+		memcpy(app->mods, plan->mods, plan->num_nodes * sizeof(mod_t *));
+
+		// connect ports to shared buffers
+		_dsp_master_unbind(app);
+
+		for(unsigned k=0; k<plan->num_bindings; k++)
+		{
+			port_t *port = plan->bindings[k].port;
+
+			port->base = plan->bindings[k].buf;
+
+			if(!port->alias)
+				lilv_instance_connect_port(port->mod->inst, port->index, port->base);
+		}
+
+		dsp_master->bound = plan;
+
+		if(plan->num_feedbacks != app->num_feedbacks)
+		{
+			sp_app_log_trace(app, "%s: graph contains %u feedback connection(s)\n",
+				__func__, plan->num_feedbacks);
+			app->num_feedbacks = plan->num_feedbacks;
+		}
+
+		for(unsigned i=0; i<plan->num_nodes; i++)
+		{
+			dsp_client_t *dsp_client = &plan->mods[i]->dsp_client;
+
+			dsp_client->node = i;
+			dsp_client->stage = plan->stages[i];
+			dsp_client->delayed = false;
+		}
+
+		for(unsigned i=0; i<plan->num_delayed; i++)
+			plan->mods[plan->delayed[i]]->dsp_client.delayed = true;
+
+		// report added latency via system ports
+		const uint32_t latency = plan->num_delayed ? app->driver->max_block_size : 0;
+		if(atomic_exchange_explicit(&app->latency, latency, memory_order_relaxed) != latency)
+		{
+			for(unsigned i=0; i<plan->num_nodes; i++)
+			{
+				mod_t *mod = plan->mods[i];
+
+				if(!mod->system_ports)
+					continue; // skip
+
+				job_t *job = _sp_app_to_worker_request(app, sizeof(job_t));
+				if(job)
+				{
+					job->request = JOB_TYPE_REQUEST_MODULE_SYSTEM_PORTS_UPDATE;
+					job->mod = mod;
+					_sp_app_to_worker_advance(app, sizeof(job_t));
+				}
+				else
+				{
+					sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
+				}
+			}
+		}
+
+#if !defined(USE_DYNAMIC_PARALLELIZER)
+		dsp_master->concurrent = plan->concurrent;
+
+		// to nk
+		LV2_Atom *answer = _sp_app_to_ui_request_atom(app);
+		if(answer)
+		{
+			const int32_t cpus_used = (app->dsp_master.concurrent > app->dsp_master.num_slaves + 1)
+				? app->dsp_master.num_slaves + 1
+				: app->dsp_master.concurrent;
+
+			LV2_Atom_Forge_Ref ref = synthpod_patcher_set(
+				&app->regs, &app->forge, 0, 0, app->regs.synthpod.cpus_used.urid,
+				sizeof(int32_t), app->forge.Int, &cpus_used); //TODO subj, seqn
+			if(ref)
+			{
+				_sp_app_to_ui_advance_atom(app, answer);
+			}
+			else
+			{
+				_sp_app_to_ui_overflow(app);
+			}
+		}
+		else
+		{
+			_sp_app_to_ui_overflow(app);
+		}
+#endif
+	}
+
+	if(!old)
+		return;
+
+	// signal to worker
+	job_t *job = _sp_app_to_worker_request(app, sizeof(job_t));
+	if(job)
+	{
+		job->request = JOB_TYPE_REQUEST_PLAN_FREE;
+		job->plan = old;
+		_sp_app_to_worker_advance(app, sizeof(job_t));
+	}
+	else
+	{
+		sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
+	}
+}
+
+// install plan that has arrived while worker owned graph
+__realtime void
+_dsp_master_unpark(sp_app_t *app)
+{
+	dsp_master_t *dsp_master = &app->dsp_master;
+	dsp_plan_t *plan = dsp_master->parked;
+
+	if(!plan || (app->block_state == BLOCKING_STATE_WAIT))
+		return; // nothing to do or graph still owned by worker
+
+	dsp_master->parked = NULL;
+	_dsp_master_plan_set(app, plan); // frees it if graph has changed meanwhile
+}
+
+bool
+_sp_app_port_connected(sp_app_t *app, port_t *src_port, port_t *snk_port, float gain)
+{
+	connectable_t *conn = _sp_app_port_connectable(snk_port);
+	if(conn)
+	{
+		for(int s = 0; s < conn->num_sources; s++)
+		{
+			source_t *src = &conn->sources[s];
+
+			if(src->port == src_port)
+			{
+				// glide towards new gain instead of stepping
+				if(gain != src->gain)
+				{
+					src->gain = gain;
+					src->smooth.samples = app->ramp_samples;
+				}
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+int
+_sp_app_port_connect(sp_app_t *app, port_t *src_port, port_t *snk_port, float gain)
+{
+	if(_sp_app_port_connected(app, src_port, snk_port, gain))
+		return 0;
+
+	connectable_t *conn = _sp_app_port_connectable(snk_port);
+	if(!conn)
+	{
+		sp_app_log_trace(app, "%s: invalid connectable\n", __func__);
+		return 0;
+	}
+
+	if(conn->num_sources >= conn->max_sources)
+	{
+		const int max_sources = conn->max_sources ? conn->max_sources << 1 : 1;
+
+		if(app->block_state == BLOCKING_STATE_WAIT) // called from worker
+		{
+			source_t *sources = realloc(conn->sources, _sp_app_sources_size(max_sources));
+			if(!sources)
+			{
+				sp_app_log_error(app, "%s: source list allocation failed\n", __func__);
+				return 0;
+			}
+
+			_sp_app_sources_set(conn, sources, max_sources);
+		}
+		else
+		{
+			// signal to worker, connection will be made once grown list is back
+			job_t *job = _sp_app_to_worker_request(app, sizeof(job_t));
+			if(job)
+			{
+				job->request = JOB_TYPE_REQUEST_SOURCES_ALLOC;
+				job->urn = snk_port->mod->urn;
+				job->conn.sources = NULL;
+				job->conn.max_sources = max_sources;
+				job->conn.snk_index = snk_port->index;
+				job->conn.src_urn = src_port->mod->urn;
+				job->conn.src_index = src_port->index;
+				job->conn.gain = gain;
+				_sp_app_to_worker_advance(app, sizeof(job_t));
+			}
+			else
+			{
+				sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
+			}
+
+			return 0;
+		}
+	}
+
+	source_t *source = &conn->sources[conn->num_sources];
+	source->port = src_port;;
+	source->gain = gain;
+	source->smooth.samples = 0;
+	source->smooth.value = gain;
+	conn->num_sources += 1;
+
+	// only audio port connections need to be ramped to be clickless
+	if(snk_port->type == PORT_TYPE_AUDIO)
+	{
+		source->ramp.samples = app->ramp_samples;
+		source->ramp.state = RAMP_STATE_UP;
+		source->ramp.value = 0.f;
+	}
+
+	_sp_app_order(app);
+	return 1;
+}
+
+void
+_sp_app_port_disconnect(sp_app_t *app, port_t *src_port, port_t *snk_port)
+{
+	connectable_t *conn = _sp_app_port_connectable(snk_port);
+	if(!conn)
+		return;
+
+	// update sources list 
+	bool connected = false;
+	for(int i=0, j=0; i<conn->num_sources; i++)
+	{
+		if(conn->sources[i].port == src_port)
+		{
+			connected = true;
+			continue;
+		}
+
+		conn->sources[j++] = conn->sources[i]; // with gain, ramp and smoothing state
+	}
+
+	if(!connected)
+		return;
+
+	conn->num_sources -= 1;
+
+	_sp_app_order(app);
+}
+
+int
+_sp_app_port_disconnect_request(sp_app_t *app, port_t *src_port, port_t *snk_port,
+	ramp_state_t ramp_state)
+{
+	if(  (src_port->direction == PORT_DIRECTION_OUTPUT)
+		&& (snk_port->direction == PORT_DIRECTION_INPUT) )
+	{
+		source_t *source = NULL;
+
+		connectable_t *conn = _sp_app_port_connectable(snk_port);
+		if(conn)
+		{
+			// find connection
+			for(int i=0; i<conn->num_sources; i++)
+			{
+				if(conn->sources[i].port == src_port)
+				{
+					source = &conn->sources[i];
+					break;
+				}
+			}
+		}
+
+		if(source)
+		{
+			if(src_port->type == PORT_TYPE_AUDIO)
+			{
+				// only audio output ports need to be ramped to be clickless
+
+				if(source->ramp.state == RAMP_STATE_NONE)
+				{
+					source->ramp.samples = app->ramp_samples;
+					source->ramp.state = ramp_state;
+					source->ramp.value = 1.f;
+				}
+
+				return 1; // needs ramping
+			}
+			else // !AUDIO
+			{
+				// disconnect immediately
+				_sp_app_port_disconnect(app, src_port, snk_port);
+			}
+		}
+	}
+
+	return 0; // not connected
+}
+
+int
+_sp_app_port_desilence(sp_app_t *app, port_t *src_port, port_t *snk_port)
+{
+	if(  (src_port->direction == PORT_DIRECTION_OUTPUT)
+		&& (snk_port->direction == PORT_DIRECTION_INPUT) )
+	{
+		source_t *source = NULL;
+
+		connectable_t *conn = _sp_app_port_connectable(snk_port);
+		if(conn)
+		{
+			// find connection
 			for(int i=0; i<conn->num_sources; i++)
 			{
 				if(conn->sources[i].port == src_port)
@@ -453,10 +1271,9 @@ _update_ramp(sp_app_t *app, source_t *source, port_t *port, uint32_t nsamples)
 		}
 		else if(source->ramp.state == RAMP_STATE_DOWN_DISABLE)
 		{
-			source->port->mod->disabled = true; // disable module in graph
+			source->port->mod->disabled = true; // disable module in graph, stops multiplexing
 			source->ramp.value = 0.f;
 			return; // stay in RAMP_STATE_DOWN_DISABLE
-			//FIXME make this more efficient, e.g. without multiplexing while disabled
 		}
 		else if(source->ramp.state == RAMP_STATE_UP)
 		{
@@ -474,6 +1291,19 @@ _update_ramp(sp_app_t *app, source_t *source, port_t *port, uint32_t nsamples)
 	}
 }
 
+__realtime static inline void
+_sp_app_port_control_stash_push(sp_app_t *app, port_t *port)
+{
+	control_port_t *control = &port->control;
+
+	control->stash_next = atomic_load_explicit(&app->stashes, memory_order_relaxed);
+	while(!atomic_compare_exchange_weak_explicit(&app->stashes, &control->stash_next,
+			port, memory_order_release, memory_order_relaxed))
+	{
+		// retry, concurrent push from other dsp thread
+	}
+}
+
 __realtime void
 _sp_app_port_control_stash(port_t *port)
 {
@@ -486,75 +1316,211 @@ _sp_app_port_control_stash(port_t *port)
 
 		_sp_app_port_unlock(control);
 	}
-	else
+	else if(!control->stashing) // push to list of pending stashes
 	{
 		control->stashing = true;
+		_sp_app_port_control_stash_push(port->mod->app, port);
 	}
 }
 
+// drop pending stashes of module about to be freed by worker
+__realtime void
+_sp_app_port_control_unstash(sp_app_t *app, mod_t *mod)
+{
+	port_t *next;
+	for(port_t *port = atomic_exchange_explicit(&app->stashes, NULL, memory_order_acquire);
+		port;
+		port = next)
+	{
+		next = port->control.stash_next;
+
+		if(port->mod == mod)
+			port->control.stashing = false;
+		else
+			_sp_app_port_control_stash_push(app, port);
+	}
+}
+
+// advance smoothed gain linearly towards target gain, returns gain at end of
+// this period, to interpolate gain over the period
+__realtime static inline float
+_update_smooth(source_t *source, uint32_t nsamples)
+{
+	if(source->smooth.samples <= (int)nsamples)
+	{
+		source->smooth.samples = 0;
+		source->smooth.value = source->gain; // target reached
+	}
+	else
+	{
+		source->smooth.value += (source->gain - source->smooth.value)
+			* (float)nsamples / (float)source->smooth.samples;
+		source->smooth.samples -= nsamples;
+	}
+
+	return source->smooth.value;
+}
+
+// update ramps of sources without multiplexing, e.g. for disabled modules
+__realtime void
+_sp_app_port_ramps_update(sp_app_t *app, port_t *port, uint32_t nsamples)
+{
+	if(port->type != PORT_TYPE_AUDIO)
+		return;
+
+	connectable_t *conn = &port->audio.connectable;
+	for(int s=0; s<conn->num_sources; s++)
+	{
+		source_t *source = &conn->sources[s];
+
+		if(source->smooth.samples)
+			_update_smooth(source, nsamples);
+
+		if(source->ramp.state != RAMP_STATE_NONE)
+			_update_ramp(app, source, port, nsamples);
+	}
+}
+
+// whether source is read one period behind in pipelined mode
+__realtime static inline bool
+_port_source_delayed(const port_t *port, const source_t *source)
+{
+	return source->port->mod->dsp_client.delayed
+		&& (source->port->mod->dsp_client.stage < port->mod->dsp_client.stage)
+		&& source->port->delay;
+}
+
+__realtime static inline const void *
+_port_source_base(const port_t *port, const source_t *source)
+{
+	return _port_source_delayed(port, source)
+		? ASSUME_CACHE_ALIGNED(source->port->delay)
+		: PORT_SIGNAL_ALIGNED(source->port);
+}
+
+__realtime static inline bool
+_port_source_silent(const port_t *port, const source_t *source)
+{
+	return source->port->audio.silent && !_port_source_delayed(port, source);
+}
+
+// ramp value at end of this period, to interpolate gain over the period
+__realtime static inline float
+_ramp_value_next(sp_app_t *app, const source_t *source, uint32_t nsamples)
+{
+	const int samples = source->ramp.samples - (int)nsamples;
+	const float value = (samples > 0)
+		? (float)samples / (float)app->ramp_samples
+		: 0.f;
+
+	return (source->ramp.state == RAMP_STATE_UP) ? 1.f - value : value;
+}
+
+// connect single source buffer directly to plugin instead of copying it,
+// unless it needs scaling, is read one period behind or closes a cycle
+__realtime static inline bool
+_port_alias(port_t *port, const connectable_t *conn)
+{
+	mod_t *mod = port->mod;
+	void *alias = NULL;
+
+	if( (conn->num_sources == 1) && !mod->system_ports) // driver reads base
+	{
+		const source_t *source = &conn->sources[0];
+
+		if(  ( (port->type != PORT_TYPE_AUDIO)
+				|| ( (source->gain == 1.f) && !source->smooth.samples) )
+			&& (source->ramp.state == RAMP_STATE_NONE)
+			&& (source->port->mod->dsp_client.node < mod->dsp_client.node)
+			&& !_port_source_delayed(port, source) )
+		{
+			alias = source->port->base;
+		}
+	}
+
+	if(alias != port->alias) // reconnect on change only
+	{
+		lilv_instance_connect_port(mod->inst, port->index, alias ? alias : port->base);
+		port->alias = alias;
+	}
+
+	return alias != NULL;
+}
+
 __realtime static inline void
 _port_audio_multiplex(sp_app_t *app, port_t *port, uint32_t nsamples)
 {
-	float *val = PORT_BASE_ALIGNED(port);
-	memset(val, 0, nsamples * sizeof(float)); // init
+	float *val = PORT_SIGNAL_ALIGNED(port);
+	bool silent = true;
+
+	connectable_t *conn = &port->audio.connectable;
+	if(_port_alias(port, conn))
+	{
+		port->audio.silent = conn->sources[0].port->audio.silent;
+		return;
+	}
 
-	connectable_t *conn = &port->audio.connectable;
 	for(int s=0; s<conn->num_sources; s++)
 	{
 		source_t *source = &conn->sources[s];
+		const bool ramping = source->ramp.state != RAMP_STATE_NONE;
+		float gain0 = source->smooth.value;
+		float gain1 = source->smooth.samples
+			? _update_smooth(source, nsamples)
+			: gain0;
 
 		// ramp audio output ports
-		if(source->ramp.state != RAMP_STATE_NONE)
+		if(ramping)
 		{
-			const float *src = PORT_BASE_ALIGNED(source->port);
-			const float gain = source->gain * source->ramp.value;
-
-			if(gain == 1.f)
-			{
-				for(uint32_t j=0; j<nsamples; j++)
-					val[j] += src[j];
-			}
-			else // gain != 1.f
-			{
-				for(uint32_t j=0; j<nsamples; j++)
-					val[j] += src[j] * gain;
-			}
-
-			_update_ramp(app, source, port, nsamples);
+			gain0 *= source->ramp.value;
+			gain1 *= _ramp_value_next(app, source, nsamples);
 		}
-		else // RAMP_STATE_NONE
+
+		if( ((gain0 != 0.f) || (gain1 != 0.f)) && !_port_source_silent(port, source) )
 		{
-			const float *src = PORT_BASE_ALIGNED(source->port);
-			const float gain = source->gain;
-			if(gain == 1.f)
-			{
-				for(uint32_t j=0; j<nsamples; j++)
-					val[j] += src[j];
-			}
-			else // gain != 1.f
-			{
-				for(uint32_t j=0; j<nsamples; j++)
-					val[j] += src[j] * gain;
-			}
+			const float *src = _port_source_base(port, source);
+
+			// first source initializes buffer, further sources accumulate
+			if(silent)
+				app->mix.copy(val, src, gain0, gain1, nsamples);
+			else
+				app->mix.add(val, src, gain0, gain1, nsamples);
+
+			silent = false;
 		}
+
+		if(ramping)
+			_update_ramp(app, source, port, nsamples);
 	}
+
+	if(silent)
+		memset(val, 0, nsamples * sizeof(float)); // nothing mixed
+
+	port->audio.silent = silent;
 }
 
 __realtime static inline void
 _port_cv_multiplex(sp_app_t *app, port_t *port, uint32_t nsamples)
 {
-	float *val = PORT_BASE_ALIGNED(port);
-	memset(val, 0, nsamples * sizeof(float)); // init
+	float *val = PORT_SIGNAL_ALIGNED(port);
 
 	connectable_t *conn = &port->cv.connectable;
+	if(_port_alias(port, conn))
+		return;
+
 	for(int s=0; s<conn->num_sources; s++)
 	{
 		source_t *source = &conn->sources[s];
 
-		const float *src = PORT_BASE_ALIGNED(source->port);
-		for(uint32_t j=0; j<nsamples; j++)
-			val[j] += src[j];
+		const float *src = _port_source_base(port, source);
+		if(s == 0)
+			app->mix.copy(val, src, 1.f, 1.f, nsamples);
+		else
+			app->mix.add(val, src, 1.f, 1.f, nsamples);
 	}
+
+	if(conn->num_sources == 0)
+		memset(val, 0, nsamples * sizeof(float)); // init
 }
 
 __realtime static inline int
@@ -583,13 +1549,48 @@ _sp_app_automate(sp_app_t *app, mod_t *mod, auto_t *automation, double value,
 		if(pre)
 		{
 			control_port_t *control = &port->control;
-
-			float *buf = PORT_BASE_ALIGNED(port);
-			*buf = control->is_integer
+			const float val = control->is_integer
 				? floor(f64)
 				: f64;
 
-			_sp_app_port_control_stash(port);
+			// ramp towards new value
+			if(  automation->smoothing && automation->smoothing_frames
+				&& !control->is_integer )
+			{
+				const uint64_t slot = UINT64_C(1) << (automation - mod->automations);
+
+				if(!(mod->auto_smoothing & slot)) // start from current value
+				{
+					const float *buf = PORT_BASE_ALIGNED(port);
+					automation->smoothing_value = *buf;
+					automation->smoothing_start = frames;
+				}
+
+				automation->smoothing_target = val;
+				automation->smoothing_remaining = automation->smoothing_frames;
+				mod->auto_smoothing |= slot;
+			}
+			else
+			{
+				// defer to sub-block boundary in split-run mode
+				split_t *split = app->split_frames && mod->splittable
+					&& (frames >= _sp_app_split_frames(app))
+					? _sp_app_mod_split_insert(mod, frames)
+					: NULL;
+
+				if(split)
+				{
+					split->index = automation->index;
+					split->value = val;
+				}
+				else
+				{
+					float *buf = PORT_BASE_ALIGNED(port);
+					*buf = val;
+
+					_sp_app_port_control_stash(port);
+				}
+			}
 		}
 	}
 	else if( (port->type == PORT_TYPE_ATOM) && automation->property )
@@ -649,209 +1650,798 @@ _sp_app_automate(sp_app_t *app, mod_t *mod, auto_t *automation, double value,
 	return do_route;
 }
 
+// compile OSC address pattern of automation into ops, to not interpret it per event
+__realtime void
+_automation_osc_compile(osc_auto_t *oauto)
+{
+	const char *path = oauto->path;
+	const size_t len = strnlen(path, sizeof(oauto->path));
+	unsigned num_ops = 0;
+	unsigned num_sets = 0;
+
+	oauto->pattern = false; // match literally via hash by default
+	oauto->num_ops = 0;
+
+	if(!memchr(path, '*', len) && !memchr(path, '?', len)
+		&& !memchr(path, '[', len) && !memchr(path, '{', len) )
+	{
+		return; // plain address
+	}
+
+	for(size_t i = 0; i < len; )
+	{
+		if(num_ops == MAX_OSC_OPS)
+			return; // too complex
+
+		osc_op_t *op = &oauto->ops[num_ops++];
+
+		switch(path[i])
+		{
+			case '?':
+			{
+				op->type = OSC_OP_ANY;
+				i += 1;
+			} break;
+			case '*':
+			{
+				op->type = OSC_OP_STAR;
+				while( (i < len) && (path[i] == '*') ) // collapse
+					i += 1;
+			} break;
+			case '[':
+			{
+				if(num_sets == MAX_OSC_SETS)
+					return; // too complex
+
+				uint64_t *set = oauto->sets[num_sets];
+				set[0] = 0;
+				set[1] = 0;
+
+				i += 1;
+				const bool negate = (i < len) && (path[i] == '!');
+				if(negate)
+					i += 1;
+
+				for( ; (i < len) && (path[i] != ']'); i++)
+				{
+					uint8_t lo = path[i];
+					uint8_t hi = lo;
+
+					if( (i + 2 < len) && (path[i+1] == '-') && (path[i+2] != ']') ) // range
+					{
+						hi = path[i+2];
+						i += 2;
+					}
+
+					for(unsigned c = lo; (c <= hi) && (c < 0x80); c++)
+						set[c >> 6] |= UINT64_C(1) << (c & 63);
+				}
+
+				if(i == len)
+					return; // unterminated
+				i += 1;
+
+				if(negate)
+				{
+					set[0] = ~set[0];
+					set[1] = ~set[1];
+				}
+				set['/' >> 6] &= ~(UINT64_C(1) << ('/' & 63)); // never match separator
+
+				op->type = OSC_OP_SET;
+				op->off = num_sets++;
+			} break;
+			case '{':
+			{
+				const size_t start = ++i;
+
+				while( (i < len) && (path[i] != '}') )
+					i += 1;
+
+				if(i == len)
+					return; // unterminated
+
+				op->type = OSC_OP_ALT;
+				op->off = start;
+				op->len = i - start;
+				i += 1;
+			} break;
+			default:
+			{
+				const size_t start = i;
+
+				while( (i < len) && !strchr("?*[{", path[i]) )
+					i += 1;
+
+				op->type = OSC_OP_LIT;
+				op->off = start;
+				op->len = i - start;
+			} break;
+		}
+	}
+
+	oauto->num_ops = num_ops;
+	oauto->pattern = true;
+}
+
+// match OSC address against compiled pattern, starting at given op
+__realtime static bool
+_automation_osc_match(const osc_auto_t *oauto, unsigned op, const char *addr)
+{
+	for( ; op < oauto->num_ops; op++)
+	{
+		const osc_op_t *o = &oauto->ops[op];
+
+		switch((osc_op_type_t)o->type)
+		{
+			case OSC_OP_LIT:
+			{
+				if(strncmp(addr, &oauto->path[o->off], o->len))
+					return false;
+
+				addr += o->len;
+			} break;
+			case OSC_OP_ANY:
+			{
+				if( (*addr == '\0') || (*addr == '/') )
+					return false;
+
+				addr += 1;
+			} break;
+			case OSC_OP_SET:
+			{
+				const uint8_t c = *addr;
+
+				if( (c == '\0') || (c >= 0x80)
+					|| !((oauto->sets[o->off][c >> 6] >> (c & 63)) & 1) )
+				{
+					return false;
+				}
+
+				addr += 1;
+			} break;
+			case OSC_OP_ALT:
+			{
+				const char *alt = &oauto->path[o->off];
+				const char *end = alt + o->len;
+
+				while(alt <= end)
+				{
+					const char *sep = memchr(alt, ',', end - alt);
+					if(!sep)
+						sep = end;
+
+					const size_t n = sep - alt;
+					if(!strncmp(addr, alt, n) && _automation_osc_match(oauto, op + 1, addr + n))
+						return true;
+
+					alt = sep + 1;
+				}
+			} return false;
+			case OSC_OP_STAR:
+			{
+				// try all lengths within current address part
+				for(const char *s = addr; ; s++)
+				{
+					if(_automation_osc_match(oauto, op + 1, s))
+						return true;
+
+					if( (*s == '\0') || (*s == '/') )
+						break;
+				}
+			} return false;
+		}
+	}
+
+	return *addr == '\0';
+}
+
+// parse OSC message or bundle, bundles are placed at their timetag if due in
+// this period
+__realtime static unsigned
+_sp_app_automation_parse_osc(sp_app_t *app, const LV2_Atom_Event *ev,
+	const LV2_Atom_Object *obj, int64_t frames, uint32_t nsamples,
+	auto_event_t *aevs, unsigned max)
+{
+	if(!max)
+		return 0;
+
+	if(lv2_osc_is_bundle_type(&app->osc_urid, obj->body.otype))
+	{
+		const LV2_Atom_Object *timetag = NULL;
+		const LV2_Atom_Tuple *items = NULL;
+
+		if(!lv2_osc_bundle_get(&app->osc_urid, obj, &timetag, &items) || !items)
+			return 0;
+
+		LV2_OSC_Schedule *osc_sched = app->driver->osc_sched;
+		if(timetag && osc_sched)
+		{
+			LV2_OSC_Timetag tt;
+			lv2_osc_timetag_get(&app->osc_urid, &timetag->atom, &tt);
+
+			const double due = osc_sched->osc2frames(osc_sched->handle,
+				lv2_osc_timetag_parse(&tt));
+
+			if( (due > frames) && (due < nsamples) ) // late ones right away
+				frames = due;
+		}
+
+		unsigned num = 0;
+		LV2_ATOM_TUPLE_FOREACH(items, item)
+		{
+			if(!lv2_atom_forge_is_object_type(&app->forge, item->type))
+				continue;
+
+			num += _sp_app_automation_parse_osc(app, ev, (const LV2_Atom_Object *)item,
+				frames, nsamples, &aevs[num], max - num);
+		}
+
+		return num;
+	}
+
+	if(lv2_osc_is_message_type(&app->osc_urid, obj->body.otype))
+	{
+		auto_event_t *aev = aevs;
+		const LV2_Atom_String *osc_path = NULL;
+		const LV2_Atom_Tuple *osc_args = NULL;
+
+		if(lv2_osc_message_get(&app->osc_urid, obj, &osc_path, &osc_args))
+		{
+			const char *path = LV2_ATOM_BODY_CONST(osc_path);
+			double val = 0.0;
+
+			LV2_ATOM_TUPLE_FOREACH(osc_args, item)
+			{
+				switch(lv2_osc_argument_type(&app->osc_urid, item))
+				{
+					case LV2_OSC_FALSE:
+					case LV2_OSC_NIL:
+					{
+						val = 0.0;
+					} break;
+					case LV2_OSC_TRUE:
+					{
+						val = 1.0;
+					} break;
+					case LV2_OSC_IMPULSE:
+					{
+						val = HUGE_VAL;
+					} break;
+					case LV2_OSC_INT32:
+					{
+						int32_t i32;
+						lv2_osc_int32_get(&app->osc_urid, item, &i32);
+						val = i32;
+					} break;
+					case LV2_OSC_INT64:
+					{
+						int64_t i64;
+						lv2_osc_int64_get(&app->osc_urid, item, &i64);
+						val = i64;
+					} break;
+					case LV2_OSC_FLOAT:
+					{
+						float f32;
+						lv2_osc_float_get(&app->osc_urid, item, &f32);
+						val = f32;
+					} break;
+					case LV2_OSC_DOUBLE:
+					{
+						double f64;
+						lv2_osc_double_get(&app->osc_urid, item, &f64);
+						val = f64;
+					} break;
+
+					case LV2_OSC_SYMBOL:
+					case LV2_OSC_BLOB:
+					case LV2_OSC_CHAR:
+					case LV2_OSC_STRING:
+					case LV2_OSC_MIDI:
+					case LV2_OSC_RGBA:
+					case LV2_OSC_TIMETAG:
+					{
+						//FIXME handle other types, especially string, blob, symbol
+					}	break;
+				}
+			}
+
+			aev->ev = ev;
+			aev->frames = frames;
+			aev->type = AUTO_TYPE_OSC;
+			aev->path = path;
+			aev->hash = _automation_osc_hash(path, sizeof(((osc_auto_t *)NULL)->path));
+			aev->value = val;
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// parse controller and OSC events once, to be dispatched to many modules,
+// returns number of automation events, bundles may give more than one
+__realtime static inline unsigned
+_sp_app_automation_parse(sp_app_t *app, const LV2_Atom_Event *ev, uint32_t nsamples,
+	auto_event_t *aevs, unsigned max)
+{
+	const LV2_Atom *atom = &ev->body;
+	const LV2_Atom_Object *obj = (const LV2_Atom_Object *)atom;
+
+	if(!max)
+		return 0;
+
+	if(  (atom->type == app->regs.port.midi.urid)
+		&& (atom->size == 3) ) // we're only interested in controller events
+	{
+		const uint8_t *msg = LV2_ATOM_BODY_CONST(atom);
+		const uint8_t cmd = msg[0] & 0xf0;
+
+		if(cmd == 0xb0) // Controller
+		{
+			auto_event_t *aev = aevs;
+
+			aev->ev = ev;
+			aev->frames = ev->time.frames;
+			aev->type = AUTO_TYPE_MIDI;
+			aev->channel = msg[0] & 0x0f;
+			aev->controller = msg[1] & 0x7f;
+			aev->value = msg[2];
+
+			return 1;
+		}
+	}
+	else if(lv2_atom_forge_is_object_type(&app->forge, atom->type))
+	{
+		return _sp_app_automation_parse_osc(app, ev, obj, ev->time.frames, nsamples,
+			aevs, max);
+	}
+	//FIXME handle other events
+
+	return 0;
+}
+
+// decode 7-bit or 14-bit controller or NRPN data entry for MIDI automation,
+// returns whether automation has got a new value
+__realtime static inline bool
+_automation_midi_decode(midi_auto_t *mauto, uint8_t channel, uint8_t controller,
+	uint8_t value, double *val)
+{
+	if( (mauto->channel != -1) && (mauto->channel != channel) )
+		return false;
+
+	switch(mauto->mode)
+	{
+		case AUTO_MIDI_MODE_CC7:
+		{
+			if( (mauto->controller != -1) && (mauto->controller != controller) )
+				return false;
+
+			*val = value;
+		} return true;
+
+		case AUTO_MIDI_MODE_CC14:
+		{
+			if(controller >= 0x40)
+				return false;
+
+			if( (mauto->controller != -1) && (mauto->controller != (controller & 0x1f)) )
+				return false;
+
+			if(controller < 0x20) // MSB, resets LSB
+			{
+				mauto->msb = value;
+				mauto->lsb = 0;
+			}
+			else
+			{
+				mauto->lsb = value;
+			}
+		} break;
+
+		case AUTO_MIDI_MODE_NRPN:
+		{
+			const int16_t selected = (mauto->selected != -1)
+				? mauto->selected
+				: 0;
+
+			switch(controller)
+			{
+				case 0x63: // NRPN MSB
+					mauto->selected = (value << 7) | (selected & 0x7f);
+					return false;
+				case 0x62: // NRPN LSB
+					mauto->selected = (selected & 0x3f80) | value;
+					return false;
+				case 0x65: // RPN MSB
+				case 0x64: // RPN LSB
+					mauto->selected = -1;
+					return false;
+				case 0x06: // data entry MSB, resets LSB
+				case 0x26: // data entry LSB
+				{
+					if(  (mauto->selected == -1)
+						|| ( (mauto->controller != -1) && (mauto->controller != mauto->selected) ) )
+					{
+						return false;
+					}
+
+					if(controller == 0x06)
+					{
+						mauto->msb = value;
+						mauto->lsb = 0;
+					}
+					else
+					{
+						mauto->lsb = value;
+					}
+				} break;
+				default:
+					return false;
+			}
+		} break;
+
+		case AUTO_MIDI_MODE_NUM:
+			return false;
+	}
+
+	*val = (mauto->msb << 7) | mauto->lsb;
+	return true;
+}
+
 __realtime static inline int
-_sp_app_automate_event(sp_app_t *app, mod_t *mod, const LV2_Atom_Event *ev,
+_sp_app_automate_parsed(sp_app_t *app, mod_t *mod, const auto_event_t *aev,
 	bool pre)
 {
-	const int64_t frames = ev->time.frames;
-	const LV2_Atom *atom = &ev->body;
-	const LV2_Atom_Object *obj = (const LV2_Atom_Object *)atom;
+	const int64_t frames = aev->frames;
+	const double val = aev->value;
 
 	int do_route = 0;
 
-	//printf("got automation\n");
-	if(  (atom->type == app->regs.port.midi.urid)
-		&& (atom->size == 3) ) // we're only interested in controller events
+	if(aev->type == AUTO_TYPE_MIDI)
 	{
-		const uint8_t *msg = LV2_ATOM_BODY_CONST(atom);
-		const uint8_t cmd = msg[0] & 0xf0;
+		const uint8_t channel = aev->channel;
+		const uint8_t controller = aev->controller;
 
-		if(cmd == 0xb0) // Controller
+		// iterate over candidate automations
+		uint64_t slots = mod->auto_index.midi[channel][controller]
+			| mod->auto_index.midi_any;
+		while(slots)
 		{
-			const uint8_t channel = msg[0] & 0x0f;
-			const uint8_t controller = msg[1];
-			const uint8_t val = msg[2];
+			const unsigned i = __builtin_ctzll(slots);
+			auto_t *automation = &mod->automations[i];
+
+			slots &= slots - 1; // clear lowest set bit
 
-			// iterate over automations
-			for(unsigned i = 0; i < MAX_AUTOMATIONS; i++)
+			if(  (automation->type == AUTO_TYPE_MIDI)
+				&& automation->snk_enabled )
 			{
-				auto_t *automation = &mod->automations[i];
+				midi_auto_t *mauto = &automation->midi;
+				double mval;
 
-				if(  (automation->type == AUTO_TYPE_MIDI)
-					&& automation->snk_enabled )
-				{
-					midi_auto_t *mauto = &automation->midi;
+				if(!_automation_midi_decode(mauto, channel, controller, val, &mval))
+					continue; // no new value for this automation
 
-					if(pre && automation->learning)
+				if(pre && automation->learning)
+				{
+					if( (mauto->channel == -1) && (mauto->controller == -1) )
 					{
-						if( (mauto->channel == -1) && (mauto->controller == -1) )
-						{
-							mauto->channel = channel;
-							mauto->controller = controller;
-
-							automation->a = val;
-							automation->b = val;
-							_automation_refresh_mul_add(automation);
+						mauto->channel = channel;
+						mauto->controller = (mauto->mode == AUTO_MIDI_MODE_NRPN)
+							? mauto->selected
+							: (mauto->mode == AUTO_MIDI_MODE_CC14)
+								? (controller & 0x1f)
+								: controller;
+
+						automation->a = mval;
+						automation->b = mval;
+						_automation_refresh_mul_add(automation);
+
+						automation->sync = true;
+					}
+					else
+					{
+						bool needs_refresh = false;
 
-							automation->sync = true;
+						if(mval < automation->a)
+						{
+							automation->a = mval;
+							needs_refresh = true;
 						}
-						else
+						else if(mval > automation->b)
 						{
-							bool needs_refresh = false;
-
-							if(val < automation->a)
-							{
-								automation->a = val;
-								needs_refresh = true;
-							}
-							else if(val > automation->b)
-							{
-								automation->b = val;
-								needs_refresh = true;
-							}
-
-							if(needs_refresh)
-							{
-								_automation_refresh_mul_add(automation);
-							}
-
-							automation->sync = true;
+							automation->b = mval;
+							needs_refresh = true;
 						}
-					}
 
-					if(  ( (mauto->channel == -1) || (mauto->channel == channel) )
-						&& ( (mauto->controller == -1) || (mauto->controller == controller) ) )
-					{
-						do_route += _sp_app_automate(app, mod, automation, msg[2], frames, pre);
+						if(needs_refresh)
+						{
+							_automation_refresh_mul_add(automation);
+						}
+
+						automation->sync = true;
 					}
 				}
+
+				do_route += _sp_app_automate(app, mod, automation, mval, frames, pre);
 			}
 		}
 	}
-	else if(lv2_osc_is_message_type(&app->osc_urid, obj->body.otype)) //FIXME also consider bundles
+	else if(aev->type == AUTO_TYPE_OSC)
 	{
-		const LV2_Atom_String *osc_path = NULL;
-		const LV2_Atom_Tuple *osc_args = NULL;
+		const char *path = aev->path;
+		const uint32_t hash = aev->hash;
 
-		if(lv2_osc_message_get(&app->osc_urid, obj, &osc_path, &osc_args))
+		// iterate over candidate automations
+		uint64_t slots = mod->auto_index.osc[hash & 0x3f]
+			| mod->auto_index.osc_any;
+		while(slots)
 		{
-			const char *path = LV2_ATOM_BODY_CONST(osc_path);
-			double val = 0.0;
-
-			LV2_ATOM_TUPLE_FOREACH(osc_args, item)
-			{
-				switch(lv2_osc_argument_type(&app->osc_urid, item))
-				{
-					case LV2_OSC_FALSE:
-					case LV2_OSC_NIL:
-					{
-						val = 0.0;
-					} break;
-					case LV2_OSC_TRUE:
-					{
-						val = 1.0;
-					} break;
-					case LV2_OSC_IMPULSE:
-					{
-						val = HUGE_VAL;
-					} break;
-					case LV2_OSC_INT32:
-					{
-						int32_t i32;
-						lv2_osc_int32_get(&app->osc_urid, item, &i32);
-						val = i32;
-					} break;
-					case LV2_OSC_INT64:
-					{
-						int64_t i64;
-						lv2_osc_int64_get(&app->osc_urid, item, &i64);
-						val = i64;
-					} break;
-					case LV2_OSC_FLOAT:
-					{
-						float f32;
-						lv2_osc_float_get(&app->osc_urid, item, &f32);
-						val = f32;
-					} break;
-					case LV2_OSC_DOUBLE:
-					{
-						double f64;
-						lv2_osc_double_get(&app->osc_urid, item, &f64);
-						val = f64;
-					} break;
+			const unsigned i = __builtin_ctzll(slots);
+			auto_t *automation = &mod->automations[i];
 
-					case LV2_OSC_SYMBOL:
-					case LV2_OSC_BLOB:
-					case LV2_OSC_CHAR:
-					case LV2_OSC_STRING:
-					case LV2_OSC_MIDI:
-					case LV2_OSC_RGBA:
-					case LV2_OSC_TIMETAG:
-					{
-						//FIXME handle other types, especially string, blob, symbol
-					}	break;
-				}
-			}
+			slots &= slots - 1; // clear lowest set bit
 
-			// iterate over automations
-			for(unsigned i = 0; i < MAX_AUTOMATIONS; i++)
+			if(  (automation->type == AUTO_TYPE_OSC)
+				&& automation->snk_enabled )
 			{
-				auto_t *automation = &mod->automations[i];
+				osc_auto_t *oauto = &automation->osc;
 
-				if(  (automation->type == AUTO_TYPE_OSC)
-					&& automation->snk_enabled )
+				if(pre && automation->learning)
 				{
-					osc_auto_t *oauto = &automation->osc;
+					if(oauto->path[0] == '\0')
+					{
+						strncpy(oauto->path, path, sizeof(oauto->path));
+						mod->auto_index.osc_hashes[i] = hash;
+						_automation_osc_compile(oauto);
+
+						automation->a = val;
+						automation->b = val;
+						_automation_refresh_mul_add(automation);
 
-					if(pre && automation->learning)
+						automation->sync = true;
+					}
+					else
 					{
-						if(oauto->path[0] == '\0')
-						{
-							strncpy(oauto->path, path, sizeof(oauto->path));
+						bool needs_refresh = false;
 
+						if(val < automation->a)
+						{
 							automation->a = val;
+							needs_refresh = true;
+						}
+						else if(val > automation->b)
+						{
 							automation->b = val;
-							_automation_refresh_mul_add(automation);
-
-							automation->sync = true;
+							needs_refresh = true;
 						}
-						else
+
+						if(needs_refresh)
 						{
-							bool needs_refresh = false;
-
-							if(val < automation->a)
-							{
-								automation->a = val;
-								needs_refresh = true;
-							}
-							else if(val > automation->b)
-							{
-								automation->b = val;
-								needs_refresh = true;
-							}
-
-							if(needs_refresh)
-							{
-								_automation_refresh_mul_add(automation);
-							}
-
-							automation->sync = true;
+							_automation_refresh_mul_add(automation);
 						}
-					}
 
-					if( (oauto->path[0] == '\0') || !strncmp(oauto->path, path, sizeof(oauto->path)) )
-					{
-						do_route += _sp_app_automate(app, mod, automation, val, frames, pre);
+						automation->sync = true;
 					}
 				}
+
+				if(  (oauto->path[0] == '\0')
+					|| (oauto->pattern
+						? _automation_osc_match(oauto, 0, path)
+						: ( (mod->auto_index.osc_hashes[i] == hash)
+							&& !strncmp(oauto->path, path, sizeof(oauto->path)) ) ) )
+				{
+					do_route += _sp_app_automate(app, mod, automation, val, frames, pre);
+				}
 			}
 		}
 	}
-	//FIXME handle other events
-	
+
+	return do_route;
+}
+
+// sort events parsed last into timeline order, bundles may have been placed
+// at different times, events at the same time keep their order
+__realtime static inline void
+_sp_app_automation_sort(auto_event_t *aevs, unsigned from, unsigned num)
+{
+	for(unsigned i=from; i<num; i++)
+	{
+		const auto_event_t tmp = aevs[i];
+		unsigned j = i;
+
+		for( ; (j > 0) && (aevs[j-1].frames > tmp.frames); j--)
+			aevs[j] = aevs[j-1];
+
+		aevs[j] = tmp;
+	}
+}
+
+__realtime static inline int
+_sp_app_automate_event(sp_app_t *app, mod_t *mod, const LV2_Atom_Event *ev,
+	uint32_t nsamples, bool pre)
+{
+	auto_event_t aevs [MAX_BUNDLE_EVENTS];
+	const unsigned num = _sp_app_automation_parse(app, ev, nsamples, aevs, MAX_BUNDLE_EVENTS);
+
+	_sp_app_automation_sort(aevs, 0, num);
+
+	int do_route = 0;
+	for(unsigned i = 0; i < num; i++)
+		do_route += _sp_app_automate_parsed(app, mod, &aevs[i], pre);
+
 	return do_route;
 }
 
+// parse events of source port once for all automation inputs it is routed to
+__realtime void
+_sp_app_port_route(sp_app_t *app, port_t *port, uint32_t nsamples)
+{
+	const LV2_Atom_Sequence *seq = PORT_BASE_ALIGNED(port);
+	auto_event_t *aevs = port->atom.auto_events;
+	int num = 0;
+
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev)
+	{
+		const int n = _sp_app_automation_parse(app, ev, nsamples,
+			&aevs[num], MAX_AUTO_EVENTS - num);
+
+		for(int i=num; i<num+n; i++)
+			aevs[i].bundled = n > 1;
+
+		_sp_app_automation_sort(aevs, num, num + n);
+		num += n;
+
+		if(num == MAX_AUTO_EVENTS)
+		{
+			num = -1; // may have overflown, have automation inputs parse themselves
+			break;
+		}
+	}
+
+	port->atom.num_auto_events = num;
+}
+
+// have all sources of automation input been parsed by router?
+__realtime static inline bool
+_port_auto_routed(const port_t *port, const connectable_t *conn)
+{
+	for(int s=0; s<conn->num_sources; s++)
+	{
+		const source_t *source = &conn->sources[s];
+
+		if(  !source->port->atom.routed
+			|| (source->port->atom.num_auto_events < 0)
+			|| _port_source_delayed(port, source) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// dispatch parsed events of all sources to automation input in timeline order
+__realtime static inline void
+_port_auto_route(sp_app_t *app, port_t *port, uint32_t nsamples)
+{
+	mod_t *mod = port->mod;
+	const uint32_t capacity = PORT_SIZE(port);
+	LV2_Atom_Sequence *dst = PORT_BASE_ALIGNED(port);
+
+	connectable_t *conn = &port->atom.connectable;
+	const LV2_Atom_Event *routed [MAX_BUNDLE_EVENTS]; // ring of recently routed bundles
+	unsigned num_routed = 0;
+	int *pos = conn->pos;
+	for(int s=0; s<conn->num_sources; s++)
+		pos[s] = 0;
+
+	while(true)
+	{
+		const auto_event_t *aev = NULL;
+		int nxt = -1;
+
+		// few sources, linear search for earliest pending event
+		for(int s=0; s<conn->num_sources; s++)
+		{
+			const port_t *src_port = conn->sources[s].port;
+
+			if(pos[s] >= src_port->atom.num_auto_events)
+				continue; // exhausted
+
+			const auto_event_t *cand = &src_port->atom.auto_events[pos[s]];
+
+			if(cand->frames >= nsamples)
+				continue; // beyond this period
+
+			if(!aev || (cand->frames < aev->frames) )
+			{
+				aev = cand;
+				nxt = s;
+			}
+		}
+
+		if(!aev)
+			break;
+
+		pos[nxt] += 1;
+
+		// directly apply control automation, only route param automation
+		if(!_sp_app_automate_parsed(app, mod, aev, true))
+			continue;
+
+		// bundles only once, their events may be interleaved with others
+		if(aev->bundled)
+		{
+			const unsigned num = num_routed < MAX_BUNDLE_EVENTS
+				? num_routed
+				: MAX_BUNDLE_EVENTS;
+			bool done = false;
+
+			for(unsigned i=0; (i<num) && !done; i++)
+				done = (routed[i] == aev->ev);
+
+			if(done)
+				continue;
+
+			routed[num_routed++ % MAX_BUNDLE_EVENTS] = aev->ev;
+		}
+
+		LV2_Atom_Event *ev2 = lv2_atom_sequence_append_event(dst, capacity, aev->ev);
+		if(ev2)
+		{
+			ev2->time.frames = aev->frames; // keep sequence in timeline order
+		}
+		else
+		{
+			sp_app_log_trace(app, "%s: failed to append\n", __func__);
+		}
+	}
+}
+
+// whether next event of source a precedes the one of source b, events at the
+// same time are ordered by source to keep merge stable
+__realtime static inline bool
+_seq_before(const LV2_Atom_Event **itr, int a, int b)
+{
+	return (itr[a]->time.frames < itr[b]->time.frames)
+		|| ( (itr[a]->time.frames == itr[b]->time.frames) && (a < b) );
+}
+
+// restore min-heap property downwards from given heap position
+__realtime static inline void
+_seq_heap_down(int *heap, int num, const LV2_Atom_Event **itr, int i)
+{
+	while(true)
+	{
+		const int l = 2*i + 1;
+		const int r = l + 1;
+		int m = i;
+
+		if( (l < num) && _seq_before(itr, heap[l], heap[m]) )
+			m = l;
+		if( (r < num) && _seq_before(itr, heap[r], heap[m]) )
+			m = r;
+
+		if(m == i)
+			break;
+
+		const int tmp = heap[i];
+		heap[i] = heap[m];
+		heap[m] = tmp;
+		i = m;
+	}
+}
+
+// whether source has an event left in this period
+__realtime static inline bool
+_seq_pending(const LV2_Atom_Sequence *seq, const LV2_Atom_Event *itr, uint32_t nsamples)
+{
+	return !lv2_atom_sequence_is_end(&seq->body, seq->atom.size, itr)
+		&& (itr->time.frames < nsamples);
+}
+
 __realtime static inline void
 _port_seq_multiplex(sp_app_t *app, port_t *port, uint32_t nsamples)
 {
@@ -864,11 +2454,18 @@ _port_seq_multiplex(sp_app_t *app, port_t *port, uint32_t nsamples)
 	LV2_Atom_Sequence *dst = PORT_BASE_ALIGNED(port);
 
 	connectable_t *conn = &port->atom.connectable;
-	const LV2_Atom_Sequence *seq [MAX_SOURCES];
-	const LV2_Atom_Event *itr [MAX_SOURCES];
+	const LV2_Atom_Sequence *seq1 [1];
+	const LV2_Atom_Event *itr1 [1];
+	int heap1 [1];
+
+	// without source list, automation input is the only possible source
+	const LV2_Atom_Sequence **seq = conn->sources ? conn->seq : seq1;
+	const LV2_Atom_Event **itr = conn->sources ? conn->itr : itr1;
+	int *heap = conn->sources ? conn->heap : heap1;
+
 	for(int s=0; s<conn->num_sources; s++)
 	{
-		seq[s] = PORT_BASE_ALIGNED(conn->sources[s].port);
+		seq[s] = _port_source_base(port, &conn->sources[s]);
 		itr[s] = lv2_atom_sequence_begin(&seq[s]->body);
 	}
 
@@ -883,62 +2480,112 @@ _port_seq_multiplex(sp_app_t *app, port_t *port, uint32_t nsamples)
 		num_sources++;
 	}
 
-	while(true)
+	// events of all sources have already been parsed by automation router
+	if( (port == auto_port) && _port_auto_routed(port, conn) )
 	{
-		int nxt = -1;
-		int64_t frames = nsamples;
+		_port_auto_route(app, port, nsamples);
 
-		// search for next event in timeline accross source ports
-		for(int s=0; s<num_sources; s++)
-		{
-			if(lv2_atom_sequence_is_end(&seq[s]->body, seq[s]->atom.size, itr[s]))
-				continue; // reached sequence end
-			
-			if(itr[s]->time.frames < frames)
-			{
-				frames = itr[s]->time.frames;
-				nxt = s;
-			}
-		}
+		return;
+	}
+
+	// single source into empty sequence, copy as a whole
+	if(  (num_sources == 1) && (conn->num_sources == 1) && (port != auto_port)
+		&& (dst->atom.size == sizeof(LV2_Atom_Sequence_Body))
+		&& (seq[0]->atom.size <= capacity) )
+	{
+		memcpy(dst + 1, seq[0] + 1, seq[0]->atom.size - sizeof(LV2_Atom_Sequence_Body));
+		dst->atom.size = seq[0]->atom.size;
+
+		return;
+	}
+
+	// merge sources in timeline order via min-heap of sources with pending events
+	int num_heap = 0;
+
+	for(int s=0; s<num_sources; s++)
+	{
+		if(_seq_pending(seq[s], itr[s], nsamples))
+			heap[num_heap++] = s;
+	}
+
+	for(int i=num_heap/2 - 1; i>=0; i--)
+		_seq_heap_down(heap, num_heap, itr, i);
+
+	while(num_heap)
+	{
+		const int nxt = heap[0];
+		const LV2_Atom_Event *ev = itr[nxt];
 
-		if(nxt >= 0) // next event found
+		if(nxt == conn->num_sources) // event from automation port
 		{
-			const LV2_Atom_Event *ev = itr[nxt];
+			_sp_app_automate_event(app, mod, ev, nsamples, false);
 
-			if(nxt == conn->num_sources) // event from automation port
-			{
-				_sp_app_automate_event(app, mod, ev, false);
-			}
-			else
+			itr[nxt] = lv2_atom_sequence_next(ev);
+		}
+		else if(port == auto_port)
+		{
+			// directly apply control automation, only route param automation
+			if(_sp_app_automate_event(app, mod, ev, nsamples, true))
 			{
-				int do_route = 0;
-
-				if(port == auto_port)
+				LV2_Atom_Event *ev2 = lv2_atom_sequence_append_event(dst, capacity, ev);
+				if(!ev2)
 				{
-					// directly apply control automation, only route param automation
-					do_route += _sp_app_automate_event(app, mod, ev, true);
+					sp_app_log_trace(app, "%s: failed to append\n", __func__);
 				}
-				else
+			}
+
+			itr[nxt] = lv2_atom_sequence_next(ev);
+		}
+		else
+		{
+			// batch run of events that precede those of all other sources
+			int rival = -1;
+			if(num_heap > 1)
+				rival = heap[1];
+			if( (num_heap > 2) && _seq_before(itr, heap[2], heap[1]) )
+				rival = heap[2];
+
+			const LV2_Atom_Event *end = lv2_atom_sequence_next(ev);
+			while(_seq_pending(seq[nxt], end, nsamples))
+			{
+				if(rival != -1)
 				{
-					do_route += 1;
+					itr[nxt] = end;
+					if(!_seq_before(itr, nxt, rival))
+						break;
 				}
 
-				if(do_route)
+				end = lv2_atom_sequence_next(end);
+			}
+
+			const uint32_t size = (const uint8_t *)end - (const uint8_t *)ev;
+			if(capacity - dst->atom.size >= size)
+			{
+				memcpy(lv2_atom_sequence_end(&dst->body, dst->atom.size), ev, size);
+				dst->atom.size += size;
+			}
+			else // append what still fits
+			{
+				for(const LV2_Atom_Event *ev1 = ev; ev1 != end; ev1 = lv2_atom_sequence_next(ev1))
 				{
-					LV2_Atom_Event *ev2 = lv2_atom_sequence_append_event(dst, capacity, ev);
+					LV2_Atom_Event *ev2 = lv2_atom_sequence_append_event(dst, capacity, ev1);
 					if(!ev2)
 					{
 						sp_app_log_trace(app, "%s: failed to append\n", __func__);
+						break;
 					}
 				}
 			}
 
-			// advance iterator
-			itr[nxt] = lv2_atom_sequence_next(ev);
+			itr[nxt] = end;
 		}
-		else
-			break; // no more events to process
-	};
+
+		// remove exhausted source or move it down to its new position
+		if(!_seq_pending(seq[nxt], itr[nxt], nsamples))
+			heap[0] = heap[--num_heap];
+
+		_seq_heap_down(heap, num_heap, itr, 0);
+	}
 }
 
 __realtime static LV2_Atom_Forge_Ref
@@ -1032,18 +2679,17 @@ _patch_notification_add(sp_app_t *app, port_t *source_port,
 __realtime static inline void
 _port_float_protocol_update(sp_app_t *app, port_t *port, uint32_t nsamples)
 {
-	bool needs_update = false;
-	float new_val = 0.f;
+	mod_t *mod = port->mod;
+	const unsigned k = port->control.slot;
 
-	const float *val = PORT_BASE_ALIGNED(port);
-	new_val = *val;
-	needs_update = new_val != port->control.last;
+	// bitmap has been refreshed right before transfers
+	if(_ctrl_bit_get(mod->ctrl.dirty, k))
+	{
+		const float *val = PORT_BASE_ALIGNED(port);
+		const float new_val = *val;
 
-	if(needs_update) // update last value
-		port->control.last = new_val;
+		mod->ctrl.last[k] = new_val; // update last value
 
-	if(needs_update)
-	{
 		// for nk
 		_patch_notification_add(app, port, app->regs.port.float_protocol.urid,
 			sizeof(float), app->forge.Float, &new_val);
@@ -1053,7 +2699,7 @@ _port_float_protocol_update(sp_app_t *app, port_t *port, uint32_t nsamples)
 __realtime static inline void
 _port_peak_protocol_update(sp_app_t *app, port_t *port, uint32_t nsamples)
 {
-	const float *vec = PORT_BASE_ALIGNED(port);
+	const float *vec = PORT_BUF_ALIGNED(port);
 
 	// find peak value in current period
 	float peak = 0.f;
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdatomic.h>
+#include <stdalign.h>
 #include <ctype.h> // isspace
 #include <math.h>
 #include <semaphore.h>
@@ -46,10 +47,16 @@
 #define URN_UUID_LENGTH 46
 
 #define NUM_FEATURES 17
-#define MAX_SOURCES 32 // TODO how many?
-#define MAX_MODS 512 // TODO how many?
-#define MAX_SLAVES 7 // e.g. 8-core machines
+#define MIN_MODS 64 // initial capacity, grows on demand
+#define MIN_EDGES (MIN_MODS * 16) // initial capacity, grows on demand
 #define MAX_AUTOMATIONS 64
+#define MAX_SPLITS 32 // pending control automation events per module and period
+#define DSP_CYCLE_ACTIVE_BITS 16 // threads participating in cycle, in low bits of generation
+#define DSP_CYCLE_ACTIVE_MASK ((1U << DSP_CYCLE_ACTIVE_BITS) - 1)
+#define MAX_AUTO_EVENTS 256 // parsed automation events per source port and period
+#define MAX_BUNDLE_EVENTS 32 // parsed automation events per OSC bundle
+#define MAX_OSC_OPS 16 // compiled ops per OSC address pattern
+#define MAX_OSC_SETS 4 // character sets per OSC address pattern
 #define ALIAS_MAX 32
 
 typedef enum _job_type_request_t job_type_request_t;
@@ -58,16 +65,25 @@ typedef enum _blocking_state_t blocking_state_t;
 typedef enum _silencing_state_t silencing_state_t;
 typedef enum _ramp_state_t ramp_state_t;
 typedef enum _auto_type_t auto_type_t;
+typedef enum _order_mark_t order_mark_t;
 
 typedef char urn_uuid_t [URN_UUID_LENGTH];
 typedef struct _dsp_slave_t dsp_slave_t;
 typedef struct _dsp_client_t dsp_client_t;
 typedef struct _dsp_master_t dsp_master_t;
+typedef struct _dsp_plan_t dsp_plan_t;
+typedef struct _dsp_deque_t dsp_deque_t;
+typedef struct _dsp_graph_t dsp_graph_t;
+typedef struct _dsp_binding_t dsp_binding_t;
 
 typedef struct _mod_worker_t mod_worker_t;
 typedef struct _midi_auto_t midi_auto_t;
+typedef enum _osc_op_type_t osc_op_type_t;
+typedef struct _osc_op_t osc_op_t;
 typedef struct _osc_auto_t osc_auto_t;
 typedef struct _auto_t auto_t;
+typedef struct _split_t split_t;
+typedef struct _auto_event_t auto_event_t;
 typedef struct _mod_t mod_t;
 typedef struct _port_t port_t;
 typedef struct _job_t job_t;
@@ -79,6 +95,8 @@ typedef struct _mod_prof_t mod_prof_t;
 
 typedef void (*port_multiplex_cb_t) (sp_app_t *app, port_t *port, uint32_t nsamples);
 typedef void (*port_transfer_cb_t) (sp_app_t *app, port_t *port, uint32_t nsamples);
+typedef void (*mix_cb_t) (float *dst, const float *src, float gain0, float gain1,
+	uint32_t nsamples);
 
 enum _silencing_state_t {
 	SILENCING_STATE_RUN = 0,
@@ -116,6 +134,12 @@ enum _ramp_state_t {
 	RAMP_STATE_DOWN_DISABLE,
 };
 
+enum _order_mark_t {
+	ORDER_MARK_NONE = 0,
+	ORDER_MARK_BUSY,
+	ORDER_MARK_DONE
+};
+
 enum _job_type_request_t {
 	JOB_TYPE_REQUEST_MODULE_SUPPORTED,
 	JOB_TYPE_REQUEST_MODULE_ADD,
@@ -128,7 +152,15 @@ enum _job_type_request_t {
 	JOB_TYPE_REQUEST_BUNDLE_SAVE,
 	JOB_TYPE_REQUEST_BUNDLE_LOAD_STATUS,
 	JOB_TYPE_REQUEST_BUNDLE_SAVE_STATUS,
-	JOB_TYPE_REQUEST_DRAIN
+	JOB_TYPE_REQUEST_DRAIN,
+	JOB_TYPE_REQUEST_GRAPH_ALLOC,
+	JOB_TYPE_REQUEST_GRAPH_FREE,
+	JOB_TYPE_REQUEST_PLAN_COMPILE,
+	JOB_TYPE_REQUEST_PLAN_FREE,
+	JOB_TYPE_REQUEST_MODS_ALLOC,
+	JOB_TYPE_REQUEST_MODS_FREE,
+	JOB_TYPE_REQUEST_SOURCES_ALLOC,
+	JOB_TYPE_REQUEST_SOURCES_FREE
 };
 
 enum _job_type_reply_t {
@@ -140,38 +172,150 @@ enum _job_type_reply_t {
 	JOB_TYPE_REPLY_PRESET_SAVE,
 	JOB_TYPE_REPLY_BUNDLE_LOAD,
 	JOB_TYPE_REPLY_BUNDLE_SAVE,
-	JOB_TYPE_REPLY_DRAIN
+	JOB_TYPE_REPLY_DRAIN,
+	JOB_TYPE_REPLY_GRAPH_ALLOC,
+	JOB_TYPE_REPLY_PLAN_COMPILE,
+	JOB_TYPE_REPLY_MODS_ALLOC,
+	JOB_TYPE_REPLY_SOURCES_ALLOC
+};
+
+// Chase-Lev work-stealing deque, owner pushes/takes at bottom, thieves steal at top
+struct _dsp_deque_t {
+	alignas(64) atomic_int top;
+	alignas(64) atomic_int bottom;
+	atomic_uint *nodes; // storage of current plan, each node is pushed at most once per cycle
 };
 
 struct _dsp_slave_t {
 	dsp_master_t *dsp_master;
-	sem_t sem;
 	pthread_t thread;
 };
 
 struct _dsp_client_t {
-	atomic_int ref_count;
-	unsigned num_sinks;
-	unsigned num_sources;
-	dsp_client_t *sinks [64]; //FIXME
+	unsigned node; // index into execution plan
+	unsigned stage; // pipeline stage, later stage runs one period behind
+	bool delayed; // outputs are read one period behind by later stage
+
+#if defined(USE_DYNAMIC_PARALLELIZER)
+	unsigned weight; // longest path from any root, including itself
+	unsigned rank; // longest path to any leaf, including itself
+#endif
+};
+
+// port connected to shared buffer
+struct _dsp_binding_t {
+	port_t *port;
+	void *buf;
+};
+
+// execution plan, compiled from graph snapshot by worker. Its structure is
+// immutable once published, but the master thread owns ranks, roots and sink
+// list order and may re-sort them in place from sp_app_run_post, which is only
+// safe after all slaves have passed the end-of-cycle barrier
+struct _dsp_plan_t {
+	unsigned version; // of graph it was compiled from
+	unsigned num_nodes;
+	unsigned num_roots;
+	unsigned num_edges;
+	unsigned num_chains; // nodes run back-to-back after their single source
+	unsigned num_feedbacks; // connections closing a cycle
+#if !defined(USE_DYNAMIC_PARALLELIZER)
+	unsigned concurrent; // maximal number of nodes runnable at once
+#endif
+
+	mod_t **mods; // topologically sorted
+	unsigned *stages; // pipeline stage per node
+	unsigned *roots; // nodes without dependencies
+	unsigned *num_sources; // initial dependency count
+	int *chain; // fused single sink to run right away, -1 if none
+#if defined(USE_DYNAMIC_PARALLELIZER)
+	unsigned *ranks; // from last measurement, written by master after barrier
+#endif
 
+	unsigned num_delayed;
+	unsigned *delayed; // nodes to copy outputs to delay buffers for
+
+	unsigned num_bindings;
+	dsp_binding_t *bindings;
+	unsigned num_buffers;
+	void *buffers; // shared audio and CV buffers
+
+	unsigned *sources_offset;
+	unsigned *sources; // predecessor node indices
+	unsigned *sinks_offset;
+	unsigned *sinks; // successor node indices
+
+	atomic_int *ref_counts; // remaining dependencies per node
+	atomic_uint *queues; // deque storage per participating thread
+
+	uint64_t data []; // all of the above node and edge lists
+};
+
+// snapshot of module graph, taken by DSP and compiled to plan by worker
+struct _dsp_graph_t {
+	unsigned max_nodes;
+	unsigned max_edges;
+	unsigned version;
+	unsigned num_nodes;
+
+	mod_t **mods; // in current order
+	bool *delayable; // has delay buffers for pipelined mode
+	bool *poolable; // may use shared buffers
 #if defined(USE_DYNAMIC_PARALLELIZER)
-	unsigned weight;
-#else
-	int count;
-	unsigned mark;
+	unsigned *ranks;
 #endif
+
+	unsigned *sources_offset;
+	unsigned *sources; // source node per connection, may repeat
+
+	uint64_t data []; // all of the above node and edge lists
 };
 
 struct _dsp_master_t {
-	dsp_slave_t dsp_slaves [MAX_SLAVES];
+	dsp_slave_t *dsp_slaves;
 	atomic_bool kill;
 	atomic_bool emergency_exit;
 	atomic_bool xrun_report;
-	sem_t sem;
+	atomic_uint generation; // bumped by master to start a cycle, see DSP_CYCLE_*
+	atomic_uint num_sleeping; // slaves blocked in futex or semaphore
+	atomic_uint num_finished; // slaves done with current cycle
+	unsigned spin_budget; // iterations slaves spin before blocking
+#if !defined(__linux__)
+	sem_t sem; // fallback to wake up slaves
+#endif
 	unsigned concurrent;
 	unsigned num_slaves;
 	uint32_t nsamples;
+
+	_Atomic(dsp_plan_t *) plan;
+	unsigned version; // bumped whenever graph changes
+	bool stale; // graph has changed since last snapshot
+	bool plan_pending; // waiting for worker to compile plan
+	dsp_plan_t *parked; // compiled plan waiting for worker to release graph
+	dsp_graph_t *graph;
+	bool graph_pending; // waiting for worker to grow graph
+	dsp_plan_t *bound; // plan whose shared buffers are connected
+
+	// scratch for plan compilation, worker only, grows with graph
+	unsigned max_scratch;
+	unsigned words; // per bit set row
+	void *scratch;
+	order_mark_t *marks;
+	unsigned *order; // graph node per plan node
+	unsigned *position; // plan node per graph node
+	unsigned *stamps;
+	unsigned *levels;
+	bool *flags;
+	bool *pool_out;
+	uint64_t *ancestors; // bit set row per node, nodes guaranteed to have run
+	uint64_t *readers; // bit set row per node, nodes reading outputs
+#if !defined(USE_DYNAMIC_PARALLELIZER)
+	int *counts;
+#endif
+
+	atomic_uint num_done; // nodes finished in this cycle
+	unsigned num_active; // threads participating in this cycle
+	dsp_deque_t *deques; // master + slaves
 };
 
 struct _job_t {
@@ -182,8 +326,28 @@ struct _job_t {
 	union {
 		mod_t *mod;
 		int32_t status;
+		dsp_graph_t *graph;
+		dsp_plan_t *plan;
+		struct {
+			uint32_t max_nodes;
+			uint32_t max_edges;
+		};
 	};
 	LV2_URID urn;
+	union {
+		struct {
+			mod_t **mods;
+			unsigned max_mods;
+		} table; // grown module table
+		struct {
+			source_t *sources;
+			int max_sources;
+			uint32_t snk_index; // port of module urn
+			LV2_URID src_urn; // connection to make once grown, 0 if none
+			uint32_t src_index;
+			float gain;
+		} conn; // grown source list
+	};
 };
 
 struct _pool_t {
@@ -223,11 +387,51 @@ enum _auto_type_t {
 
 struct _midi_auto_t {
 	int8_t channel;
-	int8_t controller;
+	int16_t controller; // or parameter number in NRPN mode
+	auto_midi_mode_t mode;
+	uint8_t msb; // last data bytes in 14-bit and NRPN mode
+	uint8_t lsb;
+	int16_t selected; // parameter number as of controllers 99/98, -1 for none
+};
+
+enum _osc_op_type_t {
+	OSC_OP_LIT, // literal run of characters
+	OSC_OP_ANY, // ?
+	OSC_OP_STAR, // *
+	OSC_OP_SET, // [abc], [!a-z]
+	OSC_OP_ALT // {foo,bar}
+};
+
+struct _osc_op_t {
+	uint8_t type;
+	uint8_t off; // into path or sets
+	uint8_t len;
 };
 
 struct _osc_auto_t {
 	char path [128]; //TODO how big?
+	bool pattern; // path is an address pattern, matched via compiled ops
+	unsigned num_ops;
+	osc_op_t ops [MAX_OSC_OPS];
+	uint64_t sets [MAX_OSC_SETS][2]; // ASCII bitmaps
+};
+
+struct _auto_event_t {
+	const LV2_Atom_Event *ev; // original event, to be routed to parameters
+	int64_t frames; // may differ from ev for timestamped bundles
+	bool bundled; // one of many parsed from same event
+	auto_type_t type;
+	uint8_t channel;
+	uint8_t controller;
+	const char *path;
+	uint32_t hash;
+	double value;
+};
+
+struct _split_t {
+	uint32_t frames;
+	uint32_t index; // control port
+	float value;
 };
 
 struct _auto_t {
@@ -251,6 +455,16 @@ struct _auto_t {
 	bool learning;
 	bool logarithmic;
 
+	auto_smoothing_t smoothing;
+	double smoothing_time; // seconds
+	uint32_t smoothing_frames;
+	uint32_t smoothing_remaining; // frames left of linear ramp
+	uint32_t smoothing_start; // frame of period at which ramp starts
+	float smoothing_value;
+	float smoothing_target;
+
+	double feedback_value; // pending output, last value wins
+
 	union {
 		midi_auto_t midi;
 		osc_auto_t osc;
@@ -270,6 +484,11 @@ struct _mod_t {
 	bool needs_bypassing;
 	bool bypassed;
 
+	// silence detection
+	uint32_t silence_tail; // quiet samples before module goes idle, 0 to never idle
+	uint32_t quiet_samples; // with quiet inputs and silent outputs
+	bool idle; // skip running as long as inputs stay quiet
+
 	// worker
 	struct {
 		const LV2_Worker_Interface *iface;
@@ -329,7 +548,34 @@ struct _mod_t {
 	unsigned num_ports;
 	port_t *ports;
 
+	// control ports in SoA layout for vectorized change detection
+	struct {
+		unsigned num;
+		unsigned *ports; // port indices in order of control pool
+		const float *vals; // values in control pool, NULL if not evenly tiled
+		float *last; // last notified values
+		uint64_t *dirty; // bitmap of values differing from last ones
+		uint64_t *auto_dirty; // bitmap of values to send to automation anyway
+	} ctrl;
+
+	// automation router
+	bool routed; // has outputs feeding automation inputs
+	auto_event_t *auto_events; // for all atom outputs
+
+	// control automation to apply at sub-block boundaries in split-run mode
+	bool splittable; // plugin has no event ports, which would need slicing
+	unsigned num_splits;
+	split_t splits [MAX_SPLITS];
+	uint64_t auto_smoothing; // automation slots with ramps in progress
+	uint64_t auto_feedback; // automation slots with pending output
+
+	// atom sequence ports to reinitialize every cycle, as port indices
+	unsigned num_seq_ins; // inputs to clear in sp_app_run_pre
+	unsigned num_seq_outs; // outputs to reset before plugin runs
+	unsigned *seq_ports; // inputs followed by outputs
+
 	pool_t pools [PORT_TYPE_NUM];
+	pool_t delay; // output delay buffers for pipelined mode
 	mod_prof_t prof;
 
 	dsp_client_t dsp_client;
@@ -342,6 +588,16 @@ struct _mod_t {
 	char alias [ALIAS_MAX];
 	LV2_URID ui;
 	auto_t automations [MAX_AUTOMATIONS];
+
+	// automation lookup, refreshed by _sp_app_mod_automations_index
+	struct {
+		uint64_t midi [0x10][0x80]; // slots per channel and controller
+		uint64_t midi_any; // slots with wildcards or learning
+		uint16_t midi_keys [MAX_AUTOMATIONS]; // indexed table entry + 1, 0 for none
+		uint64_t osc [0x40]; // slots per path hash bucket
+		uint64_t osc_any; // slots with empty path or learning
+		uint32_t osc_hashes [MAX_AUTOMATIONS];
+	} auto_index;
 };
 
 struct _port_driver_t {
@@ -352,7 +608,7 @@ struct _port_driver_t {
 
 struct _source_t {
 	port_t *port;
-	float gain;
+	float gain; // target gain, as set by UI
 	struct {
 		float x;
 		float y;
@@ -365,6 +621,12 @@ struct _source_t {
 		ramp_state_t state;
 		float value;
 	} ramp;
+
+	// gain smoothing
+	struct {
+		int samples; // remaining samples to reach target gain
+		float value; // currently applied gain
+	} smooth;
 };
 
 typedef struct _connectable_t connectable_t;
@@ -375,7 +637,15 @@ typedef struct _atom_port_t atom_port_t;
 
 struct _connectable_t {
 	int num_sources;
-	source_t sources [MAX_SOURCES];
+	int max_sources; // grows on demand
+	source_t *sources;
+
+	// scratch for multiplexing with max_sources + 1 (automation) entries,
+	// trails source list in same allocation
+	const LV2_Atom_Sequence **seq;
+	const LV2_Atom_Event **itr;
+	int *heap;
+	int *pos;
 };
 
 struct _control_port_t {
@@ -387,19 +657,21 @@ struct _control_port_t {
 	float max;
 	float range;
 	float range_1;
-	float last;
+	unsigned slot; // index into module's control arrays
+	float quiet; // last value seen by silence detection
 	int32_t i32;
 	float f32;
-	bool auto_dirty;
 
 	float stash;
 	bool stashing;
+	port_t *stash_next; // next port in list of pending stashes
 	atomic_flag lock;
 };
 
 struct _audio_port_t {
 	connectable_t connectable;
 	float last;
+	bool silent; // buffer known to only contain zeros
 };
 
 struct _cv_port_t {
@@ -411,6 +683,11 @@ struct _atom_port_t {
 	connectable_t connectable;
 	port_buffer_type_t buffer_type; // none, sequence
 	bool patchable; // support patch:Message
+
+	// automation router
+	bool routed; // output feeding automation inputs, parsed once per period
+	int num_auto_events; // -1 if not parsed
+	auto_event_t *auto_events; // output ports only
 };
 
 struct _port_t {
@@ -421,6 +698,9 @@ struct _port_t {
 
 	size_t size;
 	void *base;
+	void *priv; // private buffer, base points to shared one while bound
+	void *delay; // copy of last period's output for pipelined mode
+	void *alias; // source buffer connected to plugin instead of base, if any
 
 	port_type_t type; // audio, CV, control, atom
 	port_direction_t direction; // input, output
@@ -452,6 +732,8 @@ struct _sp_app_t {
 	atomic_bool dirty;
 	unsigned skip_reweighting;
 
+	_Atomic(port_t *) stashes; // control ports with pending stash
+
 	blocking_state_t block_state;
 	silencing_state_t silence_state;
 	bool load_bundle;
@@ -468,7 +750,9 @@ struct _sp_app_t {
 	LV2_Atom_Forge forge;
 
 	unsigned num_mods;
-	mod_t *mods [MAX_MODS];
+	unsigned max_mods; // grows on demand
+	mod_t **mods;
+	unsigned num_feedbacks;
 
 	sp_app_system_source_t system_sources [64]; //FIXME, how many?
 	sp_app_system_sink_t system_sinks [64]; //FIXME, how many?
@@ -492,7 +776,22 @@ struct _sp_app_t {
 		unsigned counter;
 	} fps;
 
+	struct {
+		unsigned bound;
+		unsigned counter;
+		bool timeout; // flush automation feedback this period
+	} feedback;
+
 	int ramp_samples;
+	struct {
+		mix_cb_t copy; // first source
+		mix_cb_t add; // further sources
+	} mix;
+	bool skip_silence; // let modules with a silence tail go idle
+	bool pipelined; // run graph in two stages, one period apart
+	uint32_t split_frames; // minimum sub-block of split-run mode, 0 if disabled
+	bool split_pow2; // sub-blocks need to be powers of 2
+	atomic_uint latency; // added by pipelined mode in frames
 
 	Sratom *sratom;
 	app_prof_t prof;
@@ -502,6 +801,8 @@ struct _sp_app_t {
 	float nleft;
 
 	dsp_master_t dsp_master;
+	uint16_t cpus [CPU_SETSIZE]; // NUMA ordered CPUs to pin slaves to
+	unsigned num_cpus;
 
 	LV2_OSC_URID osc_urid;
 
@@ -527,6 +828,46 @@ extern const port_driver_t seq_port_driver;
 #define PORT_BASE_ALIGNED(PORT) ASSUME_ALIGNED((PORT)->base)
 #define PORT_SIZE(PORT) ((PORT)->size)
 
+// audio and CV buffers start at cache line boundaries
+#define PORT_SIGNAL_ALIGNED(PORT) ASSUME_CACHE_ALIGNED((PORT)->base)
+#define PORT_BUF_ALIGNED(PORT) ASSUME_CACHE_ALIGNED((PORT)->alias ? (PORT)->alias : (PORT)->base)
+
+// pad audio and CV buffers to whole cache lines, others to atoms
+static inline size_t
+_port_pad_size(port_type_t type, size_t size)
+{
+	if( (type == PORT_TYPE_AUDIO) || (type == PORT_TYPE_CV) )
+		return (size + CACHE_LINE_SIZE - 1) & ~((size_t)CACHE_LINE_SIZE - 1);
+
+	return lv2_atom_pad_size(size);
+}
+
+// effective minimum sub-block of split-run mode
+static inline uint32_t
+_sp_app_split_frames(sp_app_t *app)
+{
+	return app->split_frames > app->driver->min_block_size
+		? app->split_frames
+		: app->driver->min_block_size;
+}
+
+// insert split in timeline order after those at the same time, NULL if full
+static inline split_t *
+_sp_app_mod_split_insert(mod_t *mod, uint32_t frames)
+{
+	if(mod->num_splits >= MAX_SPLITS)
+		return NULL;
+
+	unsigned j = mod->num_splits++;
+	for( ; (j > 0) && (mod->splits[j-1].frames > frames); j--)
+		mod->splits[j] = mod->splits[j-1];
+
+	split_t *split = &mod->splits[j];
+	split->frames = frames;
+
+	return split;
+}
+
 /*
  * Debug
  */
@@ -644,6 +985,9 @@ _sp_app_to_worker_advance(sp_app_t *app, size_t written)
 void
 _sp_app_order(sp_app_t *app);
 
+void
+_sp_app_mod_outputs_delay(mod_t *mod, uint32_t nsamples);
+
 void
 _sp_app_reset(sp_app_t *app);
 
@@ -685,6 +1029,9 @@ _sp_app_mod_eject(sp_app_t *app, mod_t *mod);
 int
 _sp_app_mod_del(sp_app_t *app, mod_t *mod);
 
+int
+_sp_app_mod_table_grow(sp_app_t *app);
+
 mod_t *
 _sp_app_mod_get_by_uid(sp_app_t *app, int32_t uid);
 
@@ -700,25 +1047,110 @@ _sp_app_mod_queue_draw(mod_t *mod);
 void
 _sp_app_mod_reinstantiate(sp_app_t *app, mod_t *mod);
 
+void
+_sp_app_mod_controls_changed(mod_t *mod);
+
+void
+_sp_app_mod_automations_index(mod_t *mod);
+
+// FNV-1a hash of OSC automation path
+static inline uint32_t
+_automation_osc_hash(const char *path, size_t len)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	for(size_t i=0; (i < len) && path[i]; i++)
+	{
+		hash ^= (uint8_t)path[i];
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+static inline bool
+_ctrl_bit_get(const uint64_t *bits, unsigned k)
+{
+	return (bits[k >> 6] >> (k & 63)) & 1;
+}
+
+static inline void
+_ctrl_bit_set(uint64_t *bits, unsigned k)
+{
+	bits[k >> 6] |= UINT64_C(1) << (k & 63);
+}
+
+// set last notified value of control port
+static inline void
+_sp_app_port_control_last_set(port_t *port, float last)
+{
+	port->mod->ctrl.last[port->control.slot] = last;
+}
+
+// have control port value sent to output automation in next cycle
+static inline void
+_sp_app_port_control_auto_dirty(port_t *port)
+{
+	_ctrl_bit_set(port->mod->ctrl.auto_dirty, port->control.slot);
+}
+
+/*
+ * Mix
+ */
+void
+_sp_app_mix_init(sp_app_t *app);
+
 /*
  * Port
  */
-void 
-_dsp_master_reorder(sp_app_t *app);
+#if defined(USE_DYNAMIC_PARALLELIZER)
+void
+_dsp_plan_prioritize(dsp_plan_t *plan);
+#endif
+
+dsp_plan_t *
+_dsp_plan_new(sp_app_t *app, const dsp_graph_t *graph);
+
+void
+_dsp_plan_free(dsp_plan_t *plan);
+
+void
+_dsp_master_unbind(sp_app_t *app);
+
+dsp_graph_t *
+_dsp_graph_new(unsigned max_nodes, unsigned max_edges);
+
+void
+_dsp_master_snapshot(sp_app_t *app);
+
+void
+_dsp_master_plan_set(sp_app_t *app, dsp_plan_t *plan);
+
+void
+_dsp_master_unpark(sp_app_t *app);
 
 void
 _sp_app_port_disconnect(sp_app_t *app, port_t *src_port, port_t *snk_port);
 
+void
+_sp_app_port_ramps_update(sp_app_t *app, port_t *port, uint32_t nsamples);
+
 int
 _sp_app_port_disconnect_request(sp_app_t *app, port_t *src_port, port_t *snk_port,
 	ramp_state_t ramp_state);
 
 bool
-_sp_app_port_connected(port_t *src_port, port_t *snk_port, float gain);
+_sp_app_port_connected(sp_app_t *app, port_t *src_port, port_t *snk_port, float gain);
 
 int
 _sp_app_port_connect(sp_app_t *app, port_t *src_port, port_t *snk_port, float gain);
 
+void
+_sp_app_port_route(sp_app_t *app, port_t *port, uint32_t nsamples);
+
+void
+_automation_osc_compile(osc_auto_t *oauto);
+
 int
 _sp_app_port_silence_request(sp_app_t *app, port_t *src_port, port_t *snk_port,
 	ramp_state_t ramp_state);
@@ -726,12 +1158,40 @@ _sp_app_port_silence_request(sp_app_t *app, port_t *src_port, port_t *snk_port,
 void
 _sp_app_port_control_stash(port_t *port);
 
+void
+_sp_app_port_control_unstash(sp_app_t *app, mod_t *mod);
+
 int
 _sp_app_port_desilence(sp_app_t *app, port_t *src_port, port_t *snk_port);
 
 connectable_t *
 _sp_app_port_connectable(port_t *src_port);
 
+// size of source list with trailing scratch for multiplexing
+static inline size_t
+_sp_app_sources_size(int max_sources)
+{
+	const int num = max_sources + 1; // + automation
+
+	return max_sources * sizeof(source_t)
+		+ num * (sizeof(LV2_Atom_Sequence *) + sizeof(LV2_Atom_Event *))
+		+ num * 2 * sizeof(int);
+}
+
+static inline void
+_sp_app_sources_set(connectable_t *conn, source_t *sources, int max_sources)
+{
+	const int num = max_sources + 1; // + automation
+
+	conn->sources = sources;
+	conn->max_sources = max_sources;
+
+	conn->seq = (const LV2_Atom_Sequence **)&sources[max_sources];
+	conn->itr = (const LV2_Atom_Event **)&conn->seq[num];
+	conn->heap = (int *)&conn->itr[num];
+	conn->pos = &conn->heap[num];
+}
+
 static inline void
 _sp_app_port_spin_lock(control_port_t *control)
 {
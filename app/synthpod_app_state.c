@@ -195,10 +195,10 @@ _state_set_value(const char *symbol, void *data,
 		// FIXME not rt-safe
 		float *buf_ptr = PORT_BASE_ALIGNED(tar);
 		*buf_ptr = val;
-		control->last = tar->subscriptions
+		_sp_app_port_control_last_set(tar, tar->subscriptions
 			? val - 0.1 // trigger notification
-			: val; // don't trigger any notifications
-		control->auto_dirty = true; // trigger output automation
+			: val); // don't trigger any notifications
+		_sp_app_port_control_auto_dirty(tar); // trigger output automation
 		// FIXME not rt-safe
 
 		_sp_app_port_spin_lock(control);
@@ -1011,6 +1011,12 @@ sp_app_save(sp_app_t *app, LV2_State_Store_Function store,
 								&& lv2_atom_forge_bool(forge, mod->disabled);
 						}
 
+						if(ref && mod->silence_tail)
+						{
+							ref = lv2_atom_forge_key(forge, app->regs.synthpod.module_tail.urid)
+								&& lv2_atom_forge_float(forge, (float)mod->silence_tail / app->driver->sample_rate);
+						}
+
 						if(ref)
 						{
 							ref = lv2_atom_forge_key(forge, app->regs.synthpod.module_created.urid)
@@ -1234,6 +1240,9 @@ sp_app_save(sp_app_t *app, LV2_State_Store_Function store,
 									&& lv2_atom_forge_key(forge, app->regs.midi.controller_number.urid)
 									&& lv2_atom_forge_int(forge, mauto->controller)
 
+									&& lv2_atom_forge_key(forge, app->regs.synthpod.controller_mode.urid)
+									&& lv2_atom_forge_int(forge, mauto->mode)
+
 									&& lv2_atom_forge_key(forge, app->regs.synthpod.source_min.urid)
 									&& lv2_atom_forge_double(forge, automation->a)
 
@@ -1250,7 +1259,13 @@ sp_app_save(sp_app_t *app, LV2_State_Store_Function store,
 									&& lv2_atom_forge_bool(forge, automation->src_enabled)
 
 									&& lv2_atom_forge_key(forge, app->regs.synthpod.sink_enabled.urid)
-									&& lv2_atom_forge_bool(forge, automation->snk_enabled);
+									&& lv2_atom_forge_bool(forge, automation->snk_enabled)
+
+									&& lv2_atom_forge_key(forge, app->regs.synthpod.smoothing.urid)
+									&& lv2_atom_forge_int(forge, automation->smoothing)
+
+									&& lv2_atom_forge_key(forge, app->regs.synthpod.smoothing_time.urid)
+									&& lv2_atom_forge_double(forge, automation->smoothing_time);
 
 								if(ref)
 								{
@@ -1302,7 +1317,13 @@ sp_app_save(sp_app_t *app, LV2_State_Store_Function store,
 									&& lv2_atom_forge_bool(forge, automation->src_enabled)
 
 									&& lv2_atom_forge_key(forge, app->regs.synthpod.sink_enabled.urid)
-									&& lv2_atom_forge_bool(forge, automation->snk_enabled);
+									&& lv2_atom_forge_bool(forge, automation->snk_enabled)
+
+									&& lv2_atom_forge_key(forge, app->regs.synthpod.smoothing.urid)
+									&& lv2_atom_forge_int(forge, automation->smoothing)
+
+									&& lv2_atom_forge_key(forge, app->regs.synthpod.smoothing_time.urid)
+									&& lv2_atom_forge_double(forge, automation->smoothing_time);
 
 								if(ref)
 								{
@@ -1391,6 +1412,7 @@ _mod_inject(sp_app_t *app, int32_t mod_uid, LV2_URID mod_urn, const LV2_Atom_Obj
 	const LV2_Atom_Bool *mod_visible = NULL;
 	const LV2_Atom_Bool *mod_disabled = NULL;
 	const LV2_Atom_Int *mod_created = NULL;
+	const LV2_Atom_Float *mod_tail = NULL;
 	lv2_atom_object_get(mod_obj,
 		app->regs.synthpod.module_position_x.urid, &mod_pos_x,
 		app->regs.synthpod.module_position_y.urid, &mod_pos_y,
@@ -1399,6 +1421,7 @@ _mod_inject(sp_app_t *app, int32_t mod_uid, LV2_URID mod_urn, const LV2_Atom_Obj
 		app->regs.synthpod.module_visible.urid, &mod_visible,
 		app->regs.synthpod.module_disabled.urid, &mod_disabled,
 		app->regs.synthpod.module_created.urid, &mod_created,
+		app->regs.synthpod.module_tail.urid, &mod_tail,
 		0);
 
 	const uint32_t created = mod_created && (mod_created->atom.type == app->forge.Int)
@@ -1415,6 +1438,13 @@ _mod_inject(sp_app_t *app, int32_t mod_uid, LV2_URID mod_urn, const LV2_Atom_Obj
 	}
 
 	// inject module into module graph
+	if( (app->num_mods >= app->max_mods) && _sp_app_mod_table_grow(app) )
+	{
+		sp_app_log_error(app, "%s: _sp_app_mod_table_grow failed\n", __func__);
+		_sp_app_mod_del(app, mod);
+		return NULL;
+	}
+
 	app->mods[app->num_mods] = mod;
 	app->num_mods += 1;
 
@@ -1428,6 +1458,8 @@ _mod_inject(sp_app_t *app, int32_t mod_uid, LV2_URID mod_urn, const LV2_Atom_Obj
 		? mod_disabled->body : false;
 	mod->ui = mod_ui && (mod_ui->atom.type == app->forge.URID)
 		? mod_ui->body : 0;
+	mod->silence_tail = mod_tail && (mod_tail->atom.type == app->forge.Float) && (mod_tail->body > 0.f)
+		? mod_tail->body * app->driver->sample_rate : 0;
 
 	mod->uid = mod_uid;
 
@@ -172,6 +172,11 @@ _sp_app_forge_midi_automation(sp_app_t *app, LV2_Atom_Forge_Frame *frame,
 		if(ref)
 			ref = lv2_atom_forge_int(&app->forge, mauto->controller);
 
+		if(ref)
+			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.controller_mode.urid);
+		if(ref)
+			ref = lv2_atom_forge_int(&app->forge, mauto->mode);
+
 		if(ref)
 			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.source_min.urid);
 		if(ref)
@@ -201,6 +206,16 @@ _sp_app_forge_midi_automation(sp_app_t *app, LV2_Atom_Forge_Frame *frame,
 			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.sink_enabled.urid);
 		if(ref)
 			ref = lv2_atom_forge_bool(&app->forge, automation->snk_enabled);
+
+		if(ref)
+			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.smoothing.urid);
+		if(ref)
+			ref = lv2_atom_forge_int(&app->forge, automation->smoothing);
+
+		if(ref)
+			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.smoothing_time.urid);
+		if(ref)
+			ref = lv2_atom_forge_double(&app->forge, automation->smoothing_time);
 	}
 	if(ref)
 		lv2_atom_forge_pop(&app->forge, frame);
@@ -276,6 +291,16 @@ _sp_app_forge_osc_automation(sp_app_t *app, LV2_Atom_Forge_Frame *frame,
 			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.sink_enabled.urid);
 		if(ref)
 			ref = lv2_atom_forge_bool(&app->forge, automation->snk_enabled);
+
+		if(ref)
+			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.smoothing.urid);
+		if(ref)
+			ref = lv2_atom_forge_int(&app->forge, automation->smoothing);
+
+		if(ref)
+			ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.smoothing_time.urid);
+		if(ref)
+			ref = lv2_atom_forge_double(&app->forge, automation->smoothing_time);
 	}
 	if(ref)
 		lv2_atom_forge_pop(&app->forge, frame);
@@ -787,6 +812,14 @@ _sp_app_from_ui_patch_get(sp_app_t *app, const LV2_Atom *atom)
 								ref = lv2_atom_forge_string(&app->forge, mod->alias, strlen(mod->alias));
 						}
 
+						if(mod->silence_tail)
+						{
+							if(ref)
+								ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.module_tail.urid);
+							if(ref)
+								ref = lv2_atom_forge_float(&app->forge, (float)mod->silence_tail / app->driver->sample_rate);
+						}
+
 						if(mod->ui)
 						{
 							if(ref)
@@ -858,13 +891,31 @@ _sp_app_from_ui_patch_set(sp_app_t *app, const LV2_Atom *atom)
 				&& (value->type == app->forge.Float) )
 			{
 				mod->pos.x = ((const LV2_Atom_Float *)value)->body;
-				_sp_app_order(app);
 			}
 			else if( (prop == app->regs.synthpod.module_position_y.urid)
 				&& (value->type == app->forge.Float) )
 			{
 				mod->pos.y = ((const LV2_Atom_Float *)value)->body;
-				_sp_app_order(app);
+			}
+			else if( (prop == app->regs.synthpod.module_tail.urid)
+				&& (value->type == app->forge.Float) )
+			{
+				const float tail = ((const LV2_Atom_Float *)value)->body;
+
+				mod->silence_tail = tail > 0.f
+					? tail * app->driver->sample_rate
+					: 0;
+				mod->quiet_samples = 0;
+				mod->idle = false;
+
+				// flags are only refreshed while silence detection is on
+				for(unsigned p=0; p<mod->num_ports - 4; p++) // - automation/debug ports
+				{
+					port_t *port = &mod->ports[p];
+
+					if( (port->direction == PORT_DIRECTION_OUTPUT) && (port->type == PORT_TYPE_AUDIO) )
+						port->audio.silent = false;
+				}
 			}
 			else if( (prop == app->regs.synthpod.module_alias.urid)
 				&& (value->type == app->forge.String) )
@@ -1399,10 +1450,17 @@ _subscription_list_add(sp_app_t *app, const LV2_Atom_Object *obj)
 		{
 			src_port->subscriptions += 1;
 
+			// monitored signals must not live in shared buffers
+			if(  (src_port->subscriptions == 1)
+				&& ( (src_port->type == PORT_TYPE_AUDIO) || (src_port->type == PORT_TYPE_CV) ) )
+			{
+				_sp_app_order(app);
+			}
+
 			if(src_port->type == PORT_TYPE_CONTROL)
 			{
 				const float *buf_ptr = PORT_BASE_ALIGNED(src_port);
-				src_port->control.last = *buf_ptr - 0.1; // will force notification
+				_sp_app_port_control_last_set(src_port, *buf_ptr - 0.1); // will force notification
 			}
 		}
 	}
@@ -1433,7 +1491,15 @@ _subscription_list_rem(sp_app_t *app, const LV2_Atom_Object *obj)
 		if(src_port)
 		{
 			if(src_port->subscriptions > 0)
+			{
 				src_port->subscriptions -= 1;
+
+				if(  (src_port->subscriptions == 0)
+					&& ( (src_port->type == PORT_TYPE_AUDIO) || (src_port->type == PORT_TYPE_CV) ) )
+				{
+					_sp_app_order(app);
+				}
+			}
 		}
 	}
 }
@@ -1474,8 +1540,8 @@ _notification_list_add(sp_app_t *app, const LV2_Atom_Object *obj)
 				if(snk_port->type == PORT_TYPE_CONTROL)
 				{
 					*buf_ptr = val;
-					snk_port->control.last = *buf_ptr; // we don't want any notification
-					snk_port->control.auto_dirty = true;
+					_sp_app_port_control_last_set(snk_port, *buf_ptr); // we don't want any notification
+					_sp_app_port_control_auto_dirty(snk_port);
 					_sp_app_port_control_stash(snk_port);
 				}
 				else if(snk_port->type == PORT_TYPE_CV)
@@ -1556,6 +1622,8 @@ _automation_list_rem_internal(port_t *port, LV2_URID prop)
 		else if(prop && (automation->property == prop) )
 			automation->type = AUTO_TYPE_NONE; // invalidate
 	}
+
+	_sp_app_mod_automations_index(mod);
 }
 
 __realtime static port_t *
@@ -1644,6 +1712,9 @@ _automation_list_add(sp_app_t *app, const LV2_Atom_Object *obj)
 	const LV2_Atom_Bool *src_enabled = NULL;
 	const LV2_Atom_Bool *snk_enabled = NULL;
 	const LV2_Atom_Bool *is_learning = NULL;
+	const LV2_Atom_Int *src_mode = NULL;
+	const LV2_Atom_Int *src_smoothing = NULL;
+	const LV2_Atom_Double *src_smoothing_time = NULL;
 
 	lv2_atom_object_get(obj,
 		app->regs.synthpod.sink_module.urid, &src_module,
@@ -1660,6 +1731,9 @@ _automation_list_add(sp_app_t *app, const LV2_Atom_Object *obj)
 		app->regs.synthpod.source_enabled.urid, &src_enabled,
 		app->regs.synthpod.sink_enabled.urid, &snk_enabled,
 		app->regs.synthpod.learning.urid, &is_learning,
+		app->regs.synthpod.controller_mode.urid, &src_mode,
+		app->regs.synthpod.smoothing.urid, &src_smoothing,
+		app->regs.synthpod.smoothing_time.urid, &src_smoothing_time,
 		0);
 
 	const LV2_URID src_urn = src_module
@@ -1699,6 +1773,18 @@ _automation_list_add(sp_app_t *app, const LV2_Atom_Object *obj)
 				automation->snk_enabled = snk_enabled ? snk_enabled->body : false;
 				automation->learning = is_learning ? is_learning->body : false;
 
+				automation->smoothing = src_smoothing
+					&& (src_smoothing->body > AUTO_SMOOTHING_NONE)
+					&& (src_smoothing->body < AUTO_SMOOTHING_NUM)
+						? (auto_smoothing_t)src_smoothing->body
+						: AUTO_SMOOTHING_NONE;
+				automation->smoothing_time = src_smoothing_time ? src_smoothing_time->body : 0.0;
+				automation->smoothing_frames = automation->smoothing_time > 0.0
+					? automation->smoothing_time * app->driver->sample_rate
+					: 0;
+				automation->smoothing_remaining = 0;
+				automation->smoothing_start = 0;
+
 				_automation_refresh_mul_add(automation);
 
 				if(obj->body.otype == app->regs.midi.Controller.urid)
@@ -1706,18 +1792,29 @@ _automation_list_add(sp_app_t *app, const LV2_Atom_Object *obj)
 					automation->type = AUTO_TYPE_MIDI;
 					automation->midi.channel = src_channel ? src_channel->body : -1;
 					automation->midi.controller = src_controller ? src_controller->body : -1;
+					automation->midi.mode = src_mode
+						&& (src_mode->body > AUTO_MIDI_MODE_CC7)
+						&& (src_mode->body < AUTO_MIDI_MODE_NUM)
+							? (auto_midi_mode_t)src_mode->body
+							: AUTO_MIDI_MODE_CC7;
+					automation->midi.msb = 0;
+					automation->midi.lsb = 0;
+					automation->midi.selected = -1;
 				}
 				else if(obj->body.otype == app->regs.osc.message.urid)
 				{
 					automation->type = AUTO_TYPE_OSC;
 					if(src_path)
-						strncpy(automation->osc.path, LV2_ATOM_BODY_CONST(src_path), 256);
+						strncpy(automation->osc.path, LV2_ATOM_BODY_CONST(src_path), sizeof(automation->osc.path));
 					else
 						automation->osc.path[0] = '\0';
+					_automation_osc_compile(&automation->osc);
 				}
 
 				break;
 			}
+
+			_sp_app_mod_automations_index(mod);
 		}
 	}
 }
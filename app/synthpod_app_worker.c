@@ -41,6 +41,153 @@ _sp_worker_to_app_advance(sp_app_t *app, size_t size)
 		sp_app_log_error(app, "%s: buffer advance failed\n", __func__);
 }
 
+__realtime static port_t *
+_sp_app_port_get(sp_app_t *app, LV2_URID urn, uint32_t index)
+{
+	for(unsigned m = 0; m < app->num_mods; m++)
+	{
+		mod_t *mod = app->mods[m];
+
+		if(mod->urn == urn)
+			return index < mod->num_ports ? &mod->ports[index] : NULL;
+	}
+
+	return NULL;
+}
+
+// have worker grow module table or hand back job while it owns the graph
+__realtime static void
+_sp_app_mods_request(sp_app_t *app, mod_t *mod, mod_t **mods, unsigned max_mods)
+{
+	// signal to worker
+	job_t *job = _sp_app_to_worker_request(app, sizeof(job_t));
+	if(job)
+	{
+		job->request = JOB_TYPE_REQUEST_MODS_ALLOC;
+		job->mod = mod;
+		job->table.mods = mods;
+		job->table.max_mods = max_mods;
+		_sp_app_to_worker_advance(app, sizeof(job_t));
+	}
+	else
+	{
+		sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+	}
+}
+
+// inject module into module graph, right before system sink
+__realtime static void
+_sp_app_mod_insert(sp_app_t *app, mod_t *mod)
+{
+	if(app->block_state == BLOCKING_STATE_WAIT)
+	{
+		_sp_app_mods_request(app, mod, NULL, 0); // graph is owned by worker right now
+		return;
+	}
+
+	if(app->num_mods >= app->max_mods)
+	{
+		_sp_app_mods_request(app, mod, NULL, app->max_mods << 1); // retry with grown table
+		return;
+	}
+
+	app->mods[app->num_mods] = app->mods[app->num_mods-1]; // system sink
+	app->mods[app->num_mods-1] = mod;
+	app->num_mods += 1;
+
+	_sp_app_order(app);
+
+	//signal to NK
+	LV2_Atom *answer = _sp_app_to_ui_request_atom(app);
+	if(answer)
+	{
+		LV2_Atom_Forge_Ref ref = synthpod_patcher_add(&app->regs, &app->forge,
+			0, 0, app->regs.synthpod.module_list.urid, //TODO subject
+			sizeof(uint32_t), app->forge.URID, &mod->urn);
+		if(ref)
+		{
+			_sp_app_to_ui_advance_atom(app, answer);
+		}
+		else
+		{
+			_sp_app_to_ui_overflow(app);
+		}
+	}
+	else
+	{
+		_sp_app_to_ui_overflow(app);
+	}
+}
+
+// tell UI that connection could not be made after all
+__realtime static void
+_sp_app_connection_failed(sp_app_t *app, port_t *src_port, port_t *snk_port)
+{
+	LV2_Atom *answer = _sp_app_to_ui_request_atom(app);
+	if(answer)
+	{
+		LV2_Atom_Forge_Frame frame [3];
+		LV2_Atom_Forge_Ref ref = synthpod_patcher_remove_object(&app->regs, &app->forge,
+			frame, 0, 0, app->regs.synthpod.connection_list.urid); //TODO subject
+		if(ref)
+			ref = lv2_atom_forge_object(&app->forge, &frame[2], 0, 0);
+		{
+			if(ref)
+				ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.source_module.urid);
+			if(ref)
+				ref = lv2_atom_forge_urid(&app->forge, src_port->mod->urn);
+
+			if(ref)
+				ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.source_symbol.urid);
+			if(ref)
+				ref = lv2_atom_forge_string(&app->forge, src_port->symbol, strlen(src_port->symbol));
+
+			if(ref)
+				ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.sink_module.urid);
+			if(ref)
+				ref = lv2_atom_forge_urid(&app->forge, snk_port->mod->urn);
+
+			if(ref)
+				ref = lv2_atom_forge_key(&app->forge, app->regs.synthpod.sink_symbol.urid);
+			if(ref)
+				ref = lv2_atom_forge_string(&app->forge, snk_port->symbol, strlen(snk_port->symbol));
+		}
+		if(ref)
+			lv2_atom_forge_pop(&app->forge, &frame[2]);
+		if(ref)
+		{
+			synthpod_patcher_pop(&app->forge, frame, 2);
+			_sp_app_to_ui_advance_atom(app, answer);
+		}
+		else
+		{
+			_sp_app_to_ui_overflow(app);
+		}
+	}
+	else
+	{
+		_sp_app_to_ui_overflow(app);
+	}
+}
+
+// have worker grow source list or hand back job while it owns the graph
+__realtime static void
+_sp_app_sources_request(sp_app_t *app, const job_t *job)
+{
+	// signal to worker
+	job_t *job1 = _sp_app_to_worker_request(app, sizeof(job_t));
+	if(job1)
+	{
+		*job1 = *job;
+		job1->request = JOB_TYPE_REQUEST_SOURCES_ALLOC;
+		_sp_app_to_worker_advance(app, sizeof(job_t));
+	}
+	else
+	{
+		sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+	}
+}
+
 bool
 sp_app_from_worker(sp_app_t *app, uint32_t len, const void *data)
 {
@@ -70,38 +217,7 @@ sp_app_from_worker(sp_app_t *app, uint32_t len, const void *data)
 		}
 		case JOB_TYPE_REPLY_MODULE_ADD:
 		{
-			mod_t *mod = job->mod;
-
-			if(app->num_mods >= MAX_MODS)
-				break; //TODO delete mod
-
-			// inject module into module graph
-			app->mods[app->num_mods] = app->mods[app->num_mods-1]; // system sink
-			app->mods[app->num_mods-1] = mod;
-			app->num_mods += 1;
-
-			_sp_app_order(app);
-
-			//signal to NK
-			LV2_Atom *answer = _sp_app_to_ui_request_atom(app);
-			if(answer)
-			{
-				LV2_Atom_Forge_Ref ref = synthpod_patcher_add(&app->regs, &app->forge,
-					0, 0, app->regs.synthpod.module_list.urid, //TODO subject
-					sizeof(uint32_t), app->forge.URID, &mod->urn);
-				if(ref)
-				{
-					_sp_app_to_ui_advance_atom(app, answer);
-				}
-				else
-				{
-					_sp_app_to_ui_overflow(app);
-				}
-			}
-			else
-			{
-				_sp_app_to_ui_overflow(app);
-			}
+			_sp_app_mod_insert(app, job->mod);
 
 			break;
 		}
@@ -336,6 +452,141 @@ sp_app_from_worker(sp_app_t *app, uint32_t len, const void *data)
 			assert(app->block_state == BLOCKING_STATE_DRAIN);
 			app->block_state = BLOCKING_STATE_BLOCK;
 
+			break;
+		}
+		case JOB_TYPE_REPLY_GRAPH_ALLOC:
+		{
+			dsp_master_t *dsp_master = &app->dsp_master;
+			dsp_graph_t *graph = dsp_master->graph;
+
+			dsp_master->graph_pending = false;
+
+			if(!job->graph)
+			{
+				sp_app_log_error(app, "%s: graph allocation failed, running serially\n", __func__);
+				break;
+			}
+
+			// swap in grown graph, snapshot is retaken at end of period
+			dsp_master->graph = job->graph;
+
+			// signal to worker
+			job_t *job1 = _sp_app_to_worker_request(app, sizeof(job_t));
+			if(job1)
+			{
+				job1->request = JOB_TYPE_REQUEST_GRAPH_FREE;
+				job1->graph = graph;
+				_sp_app_to_worker_advance(app, sizeof(job_t));
+			}
+			else
+			{
+				sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
+			}
+
+			break;
+		}
+		case JOB_TYPE_REPLY_PLAN_COMPILE:
+		{
+			app->dsp_master.plan_pending = false;
+			_dsp_master_plan_set(app, job->plan);
+
+			break;
+		}
+		case JOB_TYPE_REPLY_MODS_ALLOC:
+		{
+			if(app->block_state == BLOCKING_STATE_WAIT)
+			{
+				_sp_app_mods_request(app, job->mod, job->table.mods, job->table.max_mods);
+				break; // graph is owned by worker right now, retry later
+			}
+
+			mod_t **mods = job->table.mods;
+
+			if(mods && (job->table.max_mods > app->max_mods))
+			{
+				// swap in grown table
+				memcpy(mods, app->mods, app->num_mods * sizeof(mod_t *));
+				mod_t **old = app->mods;
+				app->mods = mods;
+				app->max_mods = job->table.max_mods;
+				mods = old;
+			}
+
+			if(mods)
+			{
+				// signal to worker
+				job_t *job1 = _sp_app_to_worker_request(app, sizeof(job_t));
+				if(job1)
+				{
+					job1->request = JOB_TYPE_REQUEST_MODS_FREE;
+					job1->table.mods = mods;
+					_sp_app_to_worker_advance(app, sizeof(job_t));
+				}
+				else
+				{
+					sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
+				}
+			}
+
+			_sp_app_mod_insert(app, job->mod);
+
+			break;
+		}
+		case JOB_TYPE_REPLY_SOURCES_ALLOC:
+		{
+			if(app->block_state == BLOCKING_STATE_WAIT)
+			{
+				_sp_app_sources_request(app, job);
+				break; // graph is owned by worker right now, retry later
+			}
+
+			// modules may have been removed in the meantime
+			port_t *snk_port = _sp_app_port_get(app, job->urn, job->conn.snk_index);
+			port_t *src_port = job->conn.src_urn
+				? _sp_app_port_get(app, job->conn.src_urn, job->conn.src_index)
+				: NULL;
+			connectable_t *conn = snk_port ? _sp_app_port_connectable(snk_port) : NULL;
+			source_t *sources = job->conn.sources;
+
+			if(!sources)
+			{
+				sp_app_log_error(app, "%s: source list allocation failed\n", __func__);
+
+				if(src_port && snk_port)
+					_sp_app_connection_failed(app, src_port, snk_port);
+
+				break;
+			}
+
+			if(conn && (job->conn.max_sources > conn->max_sources) )
+			{
+				// swap in grown list
+				memcpy(sources, conn->sources, conn->num_sources * sizeof(source_t));
+				source_t *old = conn->sources;
+				_sp_app_sources_set(conn, sources, job->conn.max_sources);
+				sources = old;
+			}
+
+			if(sources)
+			{
+				// signal to worker
+				job_t *job1 = _sp_app_to_worker_request(app, sizeof(job_t));
+				if(job1)
+				{
+					job1->request = JOB_TYPE_REQUEST_SOURCES_FREE;
+					job1->conn.sources = sources;
+					_sp_app_to_worker_advance(app, sizeof(job_t));
+				}
+				else
+				{
+					sp_app_log_trace(app, "%s: buffer request failed\n", __func__);
+				}
+			}
+
+			// make connection that has been waiting for grown list
+			if(src_port && snk_port)
+				_sp_app_port_connect(app, src_port, snk_port, job->conn.gain);
+
 			break;
 		}
 	}
@@ -437,14 +688,22 @@ sp_worker_from_app(sp_app_t *app, uint32_t len, const void *data)
 		{
 			mod_t *mod = job->mod;
 
-			if(mod->system_ports && strlen(mod->alias) && app->driver->system_port_set)
+			if(mod->system_ports && app->driver->system_port_set)
 			{
+				const uint32_t latency = atomic_load_explicit(&app->latency, memory_order_relaxed);
+
 				for(unsigned i=0; i<mod->num_ports - 4; i++) // - automation/debug ports
 				{
 					port_t *tar = &mod->ports[i];
 
+					if(strlen(mod->alias))
+					{
+						app->driver->system_port_set(app->data, tar->sys.data,
+							SYNTHPOD_PREFIX"#moduleAlias", mod->alias);
+					}
+
 					app->driver->system_port_set(app->data, tar->sys.data,
-						SYNTHPOD_PREFIX"#moduleAlias", mod->alias);
+						LV2_CORE__latency, &latency);
 				}
 			}
 
@@ -537,6 +796,132 @@ sp_worker_from_app(sp_app_t *app, uint32_t len, const void *data)
 				sp_app_log_error(app, "%s: buffer request failed\n", __func__);
 			}
 
+			break;
+		}
+		case JOB_TYPE_REQUEST_GRAPH_ALLOC:
+		{
+			dsp_graph_t *graph = _dsp_graph_new(job->max_nodes, job->max_edges);
+			if(!graph)
+				sp_app_log_error(app, "%s: graph allocation failed\n", __func__);
+
+			// signal to app
+			job_t *job1 = _sp_worker_to_app_request(app, sizeof(job_t));
+			if(job1)
+			{
+				job1->reply = JOB_TYPE_REPLY_GRAPH_ALLOC;
+				job1->graph = graph;
+				_sp_worker_to_app_advance(app, sizeof(job_t));
+			}
+			else
+			{
+				sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+				free(graph);
+			}
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_GRAPH_FREE:
+		{
+			free(job->graph);
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_PLAN_COMPILE:
+		{
+			dsp_plan_t *plan = _dsp_plan_new(app, job->graph);
+			if(!plan)
+				sp_app_log_error(app, "%s: plan allocation failed\n", __func__);
+
+			// signal to app
+			job_t *job1 = _sp_worker_to_app_request(app, sizeof(job_t));
+			if(job1)
+			{
+				job1->reply = JOB_TYPE_REPLY_PLAN_COMPILE;
+				job1->plan = plan;
+				_sp_worker_to_app_advance(app, sizeof(job_t));
+			}
+			else
+			{
+				sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+				_dsp_plan_free(plan);
+			}
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_PLAN_FREE:
+		{
+			_dsp_plan_free(job->plan);
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_MODS_ALLOC:
+		{
+			mod_t **mods = job->table.mods;
+
+			if(!mods && job->table.max_mods)
+			{
+				mods = calloc(job->table.max_mods, sizeof(mod_t *));
+				if(!mods)
+				{
+					sp_app_log_error(app, "%s: module table allocation failed\n", __func__);
+					_sp_app_mod_del(app, job->mod);
+					break;
+				}
+			}
+
+			// signal to app
+			job_t *job1 = _sp_worker_to_app_request(app, sizeof(job_t));
+			if(job1)
+			{
+				job1->reply = JOB_TYPE_REPLY_MODS_ALLOC;
+				job1->mod = job->mod;
+				job1->table.mods = mods;
+				job1->table.max_mods = job->table.max_mods;
+				_sp_worker_to_app_advance(app, sizeof(job_t));
+			}
+			else
+			{
+				sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+				free(mods);
+				_sp_app_mod_del(app, job->mod);
+			}
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_MODS_FREE:
+		{
+			free(job->table.mods);
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_SOURCES_ALLOC:
+		{
+			source_t *sources = job->conn.sources;
+
+			if(!sources) // reply even on failure, app rolls back pending connection
+				sources = calloc(1, _sp_app_sources_size(job->conn.max_sources));
+
+			// signal to app
+			job_t *job1 = _sp_worker_to_app_request(app, sizeof(job_t));
+			if(job1)
+			{
+				*job1 = *job;
+				job1->reply = JOB_TYPE_REPLY_SOURCES_ALLOC;
+				job1->conn.sources = sources;
+				_sp_worker_to_app_advance(app, sizeof(job_t));
+			}
+			else
+			{
+				sp_app_log_error(app, "%s: buffer request failed\n", __func__);
+				free(sources);
+			}
+
+			break;
+		}
+		case JOB_TYPE_REQUEST_SOURCES_FREE:
+		{
+			free(job->conn.sources);
+
 			break;
 		}
 	}
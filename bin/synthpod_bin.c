@@ -400,11 +400,28 @@ bin_init(bin_t *bin, uint32_t sample_rate)
 	bin->app_driver.to_worker_advance = _app_to_worker_advance;
 	bin->app_driver.to_app_request = _worker_to_app_request;
 	bin->app_driver.to_app_advance = _worker_to_app_advance;
+	if(CPU_COUNT(&bin->cpu_set) == 0) // inherit CPU set, e.g. from taskset or numactl
+	{
+		if(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &bin->cpu_set))
+		{
+			for(long cpu=0; (cpu<sysconf(_SC_NPROCESSORS_ONLN)) && (cpu<CPU_SETSIZE); cpu++)
+				CPU_SET(cpu, &bin->cpu_set);
+		}
+	}
+	if(bin->num_slaves < 0) // auto
+		bin->num_slaves = CPU_COUNT(&bin->cpu_set) - 1;
 	bin->app_driver.num_slaves = bin->num_slaves;
+	bin->app_driver.spin_budget = bin->spin_budget;
+	bin->app_driver.split_frames = bin->split_frames;
 
 	bin->app_driver.audio_prio = bin->audio_prio;
 	bin->app_driver.bad_plugins = bin->bad_plugins;
+	bin->app_driver.skip_silence = bin->skip_silence;
+	bin->app_driver.pipelined = bin->pipelined;
 	bin->app_driver.cpu_affinity = bin->cpu_affinity;
+	bin->app_driver.cpu_set = bin->cpu_set;
+	if(bin->cpu_affinity)
+		bin->num_cpus = sp_app_cpu_order(&bin->cpu_set, bin->cpus);
 	bin->app_driver.close_request = _close_request;
 	bin->app_driver.opened = _opened;
 	bin->app_driver.saved = _saved;
@@ -490,6 +507,47 @@ _gui_rolling(bin_t *bin)
 	return _gui_rolling_ipc(bin);
 }
 
+__non_realtime int
+bin_cpu_set_parse(bin_t *bin, const char *list)
+{
+	CPU_ZERO(&bin->cpu_set);
+
+	// parse comma separated list of CPUs and CPU ranges, e.g. 0-3,8,10-11
+	for(const char *ptr = list; *ptr; )
+	{
+		char *end;
+		const long from = strtol(ptr, &end, 10);
+		long to = from;
+
+		if(end == ptr)
+			return -1;
+
+		if(*end == '-')
+		{
+			ptr = end + 1;
+			to = strtol(ptr, &end, 10);
+
+			if(end == ptr)
+				return -1;
+		}
+
+		if( (from < 0) || (to < from) || (to >= CPU_SETSIZE) )
+			return -1;
+
+		for(long cpu=from; cpu<=to; cpu++)
+			CPU_SET(cpu, &bin->cpu_set);
+
+		if(*end == ',')
+			end++;
+		else if(*end != '\0')
+			return -1;
+
+		ptr = end;
+	}
+
+	return CPU_COUNT(&bin->cpu_set) ? 0 : -1;
+}
+
 __realtime void
 bin_run(bin_t *bin, const char *name, char **argv, nsmc_callback_t callback)
 {
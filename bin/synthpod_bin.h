@@ -103,10 +103,18 @@ struct _bin_t {
 	int audio_prio;
 	int worker_prio;
 	int num_slaves;
+	int spin_budget;
+	int split_frames;
 	bool bad_plugins;
+	bool skip_silence;
+	bool pipelined;
 	char socket_path [NAME_MAX];
 	int update_rate;
+	int feedback_rate;
 	bool cpu_affinity;
+	cpu_set_t cpu_set;
+	uint16_t cpus [CPU_SETSIZE]; // NUMA ordered, to pin DSP thread from RT context
+	unsigned num_cpus;
 
 	sandbox_master_driver_t sb_driver;
 	sandbox_master_t *sb;
@@ -127,6 +135,9 @@ struct _bin_t {
 void
 bin_init(bin_t *bin, uint32_t sample_rate);
 
+int
+bin_cpu_set_parse(bin_t *bin, const char *list);
+
 void
 bin_run(bin_t *bin, const char *name, char **argv, nsmc_callback_t callback);
 
@@ -21,11 +21,6 @@
 #include <ctype.h>
 #include <math.h>
 
-#if defined(__NetBSD__) || defined(__FreeBSD__) || defined(__DragonFly__) || defined(__OpenBSD__)
-#	include <pthread_np.h>
-typedef cpuset_t cpu_set_t;
-#endif
-
 #include <synthpod_bin.h>
 
 #define NANO_SECONDS 1000000000
@@ -284,10 +279,7 @@ _rt_thread(void *data)
 
 	if(handle->bin.cpu_affinity)
 	{
-		cpu_set_t cpuset;
-		CPU_ZERO(&cpuset);
-		CPU_SET(0, &cpuset);
-		if(pthread_setaffinity_np(bin->dsp_thread, sizeof(cpu_set_t), &cpuset))
+		if(sp_app_cpu_affinity(bin->cpus, bin->num_cpus, 0, bin->dsp_thread))
 			bin_log_error(bin, "%s: pthread_setaffinity_np error\n", __func__);
 	}
 
@@ -347,6 +339,7 @@ _open(const char *path, const char *name, const char *id, bin_t *bin)
 		// synthpod init
 		bin->app_driver.sample_rate = handle->srate;
 		bin->app_driver.update_rate = handle->bin.update_rate;
+		bin->app_driver.feedback_rate = handle->bin.feedback_rate;
 		bin->app_driver.max_block_size = handle->frsize;
 		bin->app_driver.min_block_size = 1;
 		bin->app_driver.seq_size = handle->seq_size;
@@ -506,6 +499,10 @@ _usage(char **argv)
 		"   [-B]                 disable bad plugins (default)\n"
 		"   [-a]                 enable CPU affinity\n"
 		"   [-A]                 disable CPU affinity (default)\n"
+		"   [-z]                 skip processing of idle modules\n"
+		"   [-Z]                 do NOT skip processing of idle modules (default)\n"
+		"   [-e]                 enable pipelined processing\n"
+		"   [-E]                 disable pipelined processing (default)\n"
 		"   [-y] audio-priority  audio thread realtime priority (70)\n"
 		"   [-Y]                 do NOT use audio thread realtime priority\n"
 		"   [-w] worker-priority worker thread realtime priority (60)\n"
@@ -516,7 +513,10 @@ _usage(char **argv)
 		"   [-p] sample-period   frames per period (1024)\n"
 		"   [-s] sequence-size   minimum sequence size (8192)\n"
 		"   [-c] slave-cores     number of slave cores (auto)\n"
-		"   [-f] update-rate     GUI update rate (25)\n\n"
+		"   [-C] cpu-list        CPUs to run DSP threads on, e.g. 0-3,8 (all)\n"
+		"   [-S] spin-budget     slave spin iterations before sleeping (10000)\n"
+		"   [-f] update-rate     GUI update rate (25)\n"
+		"   [-F] feedback-rate   automation feedback rate (update-rate)\n\n"
 		, argv[0]);
 }
 
@@ -535,19 +535,23 @@ main(int argc, char **argv)
 
 	bin->audio_prio = 70;
 	bin->worker_prio = 60;
-	bin->num_slaves = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	bin->num_slaves = -1; // auto
+	bin->spin_budget = 10000;
 	bin->bad_plugins = false;
+	bin->skip_silence = false;
+	bin->pipelined = false;
 	bin->has_gui = false;
 	bin->kill_gui = false;
 	bin->threaded_gui = false;
 	snprintf(bin->socket_path, sizeof(bin->socket_path), "shm:///synthpod-%i", getpid());
 	bin->update_rate = 25;
+	bin->feedback_rate = 0; // same as update rate
 	bin->cpu_affinity = false;
 
 	bool quiet = false;
 
 	int c;
-	while((c = getopt(argc, argv, "vhqgGkKtTbBaAy:Yw:Wul:r:p:s:c:f:")) != -1)
+	while((c = getopt(argc, argv, "vhqgGkKtTbBaAzZeEy:Yw:Wul:r:p:s:c:C:S:f:F:")) != -1)
 	{
 		switch(c)
 		{
@@ -590,6 +594,18 @@ main(int argc, char **argv)
 			case 'A':
 				bin->cpu_affinity = false;
 				break;
+			case 'z':
+				bin->skip_silence = true;
+				break;
+			case 'Z':
+				bin->skip_silence = false;
+				break;
+			case 'e':
+				bin->pipelined = true;
+				break;
+			case 'E':
+				bin->pipelined = false;
+				break;
 			case 'y':
 				bin->audio_prio = atoi(optarg);
 				break;
@@ -618,15 +634,27 @@ main(int argc, char **argv)
 				handle.seq_size = MAX(SEQ_SIZE, atoi(optarg));
 				break;
 			case 'c':
-				if(atoi(optarg) < bin->num_slaves)
-					bin->num_slaves = atoi(optarg);
+				bin->num_slaves = MAX(0, atoi(optarg));
+				break;
+			case 'C':
+				if(bin_cpu_set_parse(bin, optarg))
+				{
+					fprintf(stderr, "Invalid CPU list `%s'.\n", optarg);
+					return -1;
+				}
+				break;
+			case 'S':
+				bin->spin_budget = MAX(0, atoi(optarg));
 				break;
 			case 'f':
 				bin->update_rate = atoi(optarg);
 				break;
+			case 'F':
+				bin->feedback_rate = MAX(0, atoi(optarg));
+				break;
 			case '?':
-				if(  (optopt == 'r') || (optopt == 'p') || (optopt == 's') || (optopt == 'c')
-					|| (optopt == 'l') || (optopt == 'f') )
+				if(  (optopt == 'r') || (optopt == 'p') || (optopt == 's') || (optopt == 'c') || (optopt == 'C')
+					|| (optopt == 'S') || (optopt == 'l') || (optopt == 'f') || (optopt == 'F') )
 					fprintf(stderr, "Option `-%c' requires an argument.\n", optopt);
 				else if(isprint(optopt))
 					fprintf(stderr, "Unknown option `-%c'.\n", optopt);
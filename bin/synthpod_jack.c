@@ -22,11 +22,6 @@
 #include <limits.h>
 #include <math.h>
 
-#if defined(__NetBSD__) || defined(__FreeBSD__) || defined(__DragonFly__) || defined(__OpenBSD__)
-#	include <pthread_np.h>
-typedef cpuset_t cpu_set_t;
-#endif
-
 #include <synthpod_bin.h>
 
 #include <jack/jack.h>
@@ -68,6 +63,7 @@ struct _prog_t {
 	LV2_URID time_speed;
 
 	atomic_int kill;
+	atomic_uint latency; // added by pipelined mode in frames
 
 	char *server_name;
 	jack_client_t *client;
@@ -169,10 +165,7 @@ _process(jack_nframes_t nsamples, void *data)
 
 		if(handle->bin.cpu_affinity)
 		{
-			cpu_set_t cpuset;
-			CPU_ZERO(&cpuset);
-			CPU_SET(0, &cpuset);
-			if(pthread_setaffinity_np(bin->dsp_thread, sizeof(cpu_set_t), &cpuset))
+			if(sp_app_cpu_affinity(bin->cpus, bin->num_cpus, 0, bin->dsp_thread))
 				bin_log_trace(bin, "%s: pthread_setaffinity_np error\n", __func__);
 		}
 
@@ -732,7 +725,14 @@ _system_port_set(void *data, void *sys_port, const char *key, const void *body)
 	if(!jack_port || !handle->client)
 		return;
 
-	if(!strcmp(key, SYNTHPOD_PREFIX"#moduleAlias"))
+	if(!strcmp(key, LV2_CORE__latency))
+	{
+		const uint32_t *latency = body;
+
+		if(atomic_exchange(&handle->latency, *latency) != *latency)
+			jack_recompute_total_latencies(handle->client);
+	}
+	else if(!strcmp(key, SYNTHPOD_PREFIX"#moduleAlias"))
 	{
 #if defined(JACK_HAS_METADATA_API)
 		jack_uuid_t uuid = jack_port_uuid(jack_port);
@@ -753,6 +753,62 @@ _system_port_set(void *data, void *sys_port, const char *key, const void *body)
 	}
 }
 
+// propagate worst case latency through our ports, plus our own
+__non_realtime static void
+_latency(jack_latency_callback_mode_t mode, void *data)
+{
+	prog_t *handle = data;
+	const unsigned long from = (mode == JackCaptureLatency)
+		? JackPortIsInput
+		: JackPortIsOutput;
+	const unsigned long to = (mode == JackCaptureLatency)
+		? JackPortIsOutput
+		: JackPortIsInput;
+	jack_latency_range_t range = { .min = 0, .max = 0 };
+	bool first = true;
+
+	const char **ports = jack_get_ports(handle->client, NULL, NULL, from);
+	if(ports)
+	{
+		for(const char **name = ports; *name; name++)
+		{
+			jack_port_t *port = jack_port_by_name(handle->client, *name);
+			if(!port || !jack_port_is_mine(handle->client, port))
+				continue; // skip
+
+			jack_latency_range_t other;
+			jack_port_get_latency_range(port, mode, &other);
+
+			if(first || (other.min < range.min))
+				range.min = other.min;
+			if(first || (other.max > range.max))
+				range.max = other.max;
+			first = false;
+		}
+
+		jack_free(ports);
+	}
+
+	const uint32_t latency = atomic_load_explicit(&handle->latency, memory_order_relaxed);
+	range.min += latency;
+	range.max += latency;
+
+	ports = jack_get_ports(handle->client, NULL, NULL, to);
+	if(ports)
+	{
+		for(const char **name = ports; *name; name++)
+		{
+			jack_port_t *port = jack_port_by_name(handle->client, *name);
+			if(!port || !jack_port_is_mine(handle->client, port))
+				continue; // skip
+
+			jack_port_set_latency_range(port, mode, &range);
+		}
+
+		jack_free(ports);
+	}
+}
+
 __non_realtime static void
 _shutdown(void *data)
 {
@@ -851,6 +907,7 @@ _jack_init(prog_t *handle, const char *id)
 		return -1;
 	jack_on_shutdown(handle->client, _shutdown, handle);
 	jack_set_xrun_callback(handle->client, _xrun, handle);
+	jack_set_latency_callback(handle->client, _latency, handle);
 
 	return 0;
 }
@@ -915,6 +972,7 @@ _open(const char *path, const char *name, const char *id, bin_t *bin)
 		// synthpod init
 		bin->app_driver.sample_rate = jack_get_sample_rate(handle->client);
 		bin->app_driver.update_rate = handle->bin.update_rate;
+		bin->app_driver.feedback_rate = handle->bin.feedback_rate;
 		bin->app_driver.max_block_size = jack_get_buffer_size(handle->client);
 		bin->app_driver.min_block_size = 1;
 		bin->app_driver.seq_size = MAX(handle->seq_size,
@@ -926,6 +984,7 @@ _open(const char *path, const char *name, const char *id, bin_t *bin)
 
 		// jack activate
 		atomic_init(&handle->kill, 0);
+		atomic_init(&handle->latency, 0);
 	}
 	else
 	{
@@ -1080,12 +1139,20 @@ _usage(char **argv)
 		"   [-B]                 disable bad plugins (default)\n"
 		"   [-a]                 enable CPU affinity\n"
 		"   [-A]                 disable CPU affinity (default)\n"
+		"   [-z]                 skip processing of idle modules\n"
+		"   [-Z]                 do NOT skip processing of idle modules (default)\n"
+		"   [-e]                 enable pipelined processing\n"
+		"   [-E]                 disable pipelined processing (default)\n"
 		"   [-u]                 show alternate UI\n"
 		"   [-l] link-path       socket link path (shm:///synthpod)\n"
 		"   [-n] server-name     connect to named JACK daemon\n"
 		"   [-s] sequence-size   minimum sequence size (8192)\n"
 		"   [-c] slave-cores     number of slave cores (auto)\n"
-		"   [-f] update-rate     GUI update rate (25)\n\n"
+		"   [-C] cpu-list        CPUs to run DSP threads on, e.g. 0-3,8 (all)\n"
+		"   [-S] spin-budget     slave spin iterations before sleeping (10000)\n"
+		"   [-m] split-frames    minimum sub-block for sample accurate automation (0)\n"
+		"   [-f] update-rate     GUI update rate (25)\n"
+		"   [-F] feedback-rate   automation feedback rate (update-rate)\n\n"
 		, argv[0]);
 }
 
@@ -1102,19 +1169,24 @@ main(int argc, char **argv)
 
 	bin->audio_prio = 0; // disabled by default
 	bin->worker_prio = 0; // disabled by default
-	bin->num_slaves = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	bin->num_slaves = -1; // auto
+	bin->spin_budget = 10000;
+	bin->split_frames = 0;
 	bin->bad_plugins = false;
+	bin->skip_silence = false;
+	bin->pipelined = false;
 	bin->has_gui = false;
 	bin->kill_gui = false;
 	bin->threaded_gui = false;
 	snprintf(bin->socket_path, sizeof(bin->socket_path), "shm:///synthpod-%i", getpid());
 	bin->update_rate = 25;
+	bin->feedback_rate = 0; // same as update rate
 	bin->cpu_affinity = false;
 
 	bool quiet = false;
 
 	int c;
-	while((c = getopt(argc, argv, "vhqgGkKtTbBaAul:n:s:c:f:")) != -1)
+	while((c = getopt(argc, argv, "vhqgGkKtTbBaAzZeEul:n:s:c:C:S:m:f:F:")) != -1)
 	{
 		switch(c)
 		{
@@ -1157,6 +1229,18 @@ main(int argc, char **argv)
 			case 'A':
 				bin->cpu_affinity = false;
 				break;
+			case 'z':
+				bin->skip_silence = true;
+				break;
+			case 'Z':
+				bin->skip_silence = false;
+				break;
+			case 'e':
+				bin->pipelined = true;
+				break;
+			case 'E':
+				bin->pipelined = false;
+				break;
 			case 'u':
 				bin->d2tk_gui = true;
 				break;
@@ -1170,15 +1254,30 @@ main(int argc, char **argv)
 				handle.seq_size = MAX(SEQ_SIZE, atoi(optarg));
 				break;
 			case 'c':
-				if(atoi(optarg) < bin->num_slaves)
-					bin->num_slaves = atoi(optarg);
+				bin->num_slaves = MAX(0, atoi(optarg));
+				break;
+			case 'C':
+				if(bin_cpu_set_parse(bin, optarg))
+				{
+					fprintf(stderr, "Invalid CPU list `%s'.\n", optarg);
+					return -1;
+				}
+				break;
+			case 'S':
+				bin->spin_budget = MAX(0, atoi(optarg));
+				break;
+			case 'm':
+				bin->split_frames = MAX(0, atoi(optarg));
 				break;
 			case 'f':
 				bin->update_rate = atoi(optarg);
 				break;
+			case 'F':
+				bin->feedback_rate = MAX(0, atoi(optarg));
+				break;
 			case '?':
-				if(  (optopt == 'n') || (optopt == 's') || (optopt == 'c')
-					|| (optopt == 'l') || (optopt == 'f') )
+				if(  (optopt == 'n') || (optopt == 's') || (optopt == 'c') || (optopt == 'C')
+					|| (optopt == 'S') || (optopt == 'm') || (optopt == 'l') || (optopt == 'f') || (optopt == 'F') )
 					fprintf(stderr, "Option `-%c' requires an argument.\n", optopt);
 				else if(isprint(optopt))
 					fprintf(stderr, "Unknown option `-%c'.\n", optopt);
@@ -18,6 +18,14 @@
 #ifndef _SYNTHPOD_APP_H
 #define _SYNTHPOD_APP_H
 
+#include <sched.h>
+#include <pthread.h>
+
+#if defined(__NetBSD__) || defined(__FreeBSD__) || defined(__DragonFly__) || defined(__OpenBSD__)
+#	include <pthread_np.h>
+typedef cpuset_t cpu_set_t;
+#endif
+
 #include <lv2/lv2plug.in/ns/lv2core/lv2.h>
 #include <lv2/lv2plug.in/ns/ext/atom/atom.h>
 #include <lv2/lv2plug.in/ns/ext/atom/forge.h>
@@ -86,6 +94,7 @@ struct _sp_app_system_sink_t {
 struct _sp_app_driver_t {
 	float sample_rate;
 	float update_rate;
+	float feedback_rate; // automation feedback flushes per second, 0 for update_rate
 	uint32_t min_block_size;
 	uint32_t max_block_size;
 	uint32_t seq_size;
@@ -120,10 +129,15 @@ struct _sp_app_driver_t {
 	sp_app_features_t features;
 
 	unsigned num_slaves;
+	unsigned spin_budget;
+	uint32_t split_frames; // minimum sub-block for sample accurate automation, 0 to disable
 
 	int audio_prio;
 	bool bad_plugins;
+	bool skip_silence;
+	bool pipelined;
 	bool cpu_affinity;
+	cpu_set_t cpu_set; // CPUs to pin DSP threads to
 
 	sp_close_request_t close_request;
 	sp_opened_t opened;
@@ -191,6 +205,13 @@ sp_app_set_bundle_path(sp_app_t *app, const char *bundle_path);
 bool
 sp_app_bypassed(sp_app_t *app);
 
+unsigned
+sp_app_cpu_order(const cpu_set_t *cpu_set, uint16_t *cpus);
+
+int
+sp_app_cpu_affinity(const uint16_t *cpus, unsigned num_cpus, unsigned num,
+	pthread_t thread);
+
 uint32_t
 sp_app_options_set(sp_app_t *app, const LV2_Options_Option *options);
 
@@ -20,10 +20,14 @@
 
 #define SYNTHPOD_WORLD				SYNTHPOD_PREFIX"world"
 
+#define CACHE_LINE_SIZE 64
+
 #if defined(HAS_BUILTIN_ASSUME_ALIGNED)
 #	define ASSUME_ALIGNED(PTR) __builtin_assume_aligned((PTR), 8)
+#	define ASSUME_CACHE_ALIGNED(PTR) __builtin_assume_aligned((PTR), CACHE_LINE_SIZE)
 #else
 #	define ASSUME_ALIGNED(PTR) (PTR)
+#	define ASSUME_CACHE_ALIGNED(PTR) (PTR)
 #endif
 
 #include <lilv/lilv.h>
@@ -58,6 +62,8 @@ typedef enum _port_atom_type_t port_atom_type_t;
 typedef enum _port_buffer_type_t port_buffer_type_t;
 typedef enum _port_direction_t port_direction_t;
 typedef enum _port_protocol_t port_protocol_t;
+typedef enum _auto_midi_mode_t auto_midi_mode_t;
+typedef enum _auto_smoothing_t auto_smoothing_t;
 
 enum _port_type_t {
 	PORT_TYPE_AUDIO,
@@ -101,6 +107,24 @@ enum _port_protocol_t {
 	PORT_PROTOCOL_NUM
 }; //TODO use this
 
+// resolution of MIDI automation, serialized as spod:controllerMode
+enum _auto_midi_mode_t {
+	AUTO_MIDI_MODE_CC7 = 0,
+	AUTO_MIDI_MODE_CC14, // MSB/LSB controller pair, e.g. 7/39
+	AUTO_MIDI_MODE_NRPN, // data entry via controllers 6/38
+
+	AUTO_MIDI_MODE_NUM
+};
+
+// interpolation towards automated control values, serialized as spod:smoothing
+enum _auto_smoothing_t {
+	AUTO_SMOOTHING_NONE = 0,
+	AUTO_SMOOTHING_LINEAR,
+	AUTO_SMOOTHING_ONE_POLE,
+
+	AUTO_SMOOTHING_NUM
+};
+
 typedef int32_t u_id_t; 
 typedef struct _reg_item_t reg_item_t;
 typedef struct _reg_t reg_t;
@@ -361,6 +385,7 @@ struct _reg_t {
 		reg_item_t module_position_x;
 		reg_item_t module_position_y;
 		reg_item_t module_alias;
+		reg_item_t module_tail;
 		reg_item_t module_reinstantiate;
 		reg_item_t module_created;
 		reg_item_t node_position_x;
@@ -407,6 +432,9 @@ struct _reg_t {
 		reg_item_t source_enabled;
 		reg_item_t sink_enabled;
 		reg_item_t learning;
+		reg_item_t controller_mode;
+		reg_item_t smoothing;
+		reg_item_t smoothing_time;
 
 		reg_item_t placeholder;
 		reg_item_t visibility;
@@ -657,6 +685,7 @@ sp_regs_init(reg_t *regs, LilvWorld *world, LV2_URID_Map *map)
 	_register(&regs->synthpod.module_position_x, world, map, SYNTHPOD_PREFIX"modulePositionX");
 	_register(&regs->synthpod.module_position_y, world, map, SYNTHPOD_PREFIX"modulePositionY");
 	_register(&regs->synthpod.module_alias, world, map, SYNTHPOD_PREFIX"moduleAlias");
+	_register(&regs->synthpod.module_tail, world, map, SYNTHPOD_PREFIX"moduleTail");
 	_register(&regs->synthpod.module_reinstantiate, world, map, SYNTHPOD_PREFIX"moduleReinstantiate");
 	_register(&regs->synthpod.module_created, world, map, SYNTHPOD_PREFIX"moduleCreated");
 	_register(&regs->synthpod.node_position_x, world, map, SYNTHPOD_PREFIX"nodePositionX");
@@ -703,6 +732,9 @@ sp_regs_init(reg_t *regs, LilvWorld *world, LV2_URID_Map *map)
 	_register(&regs->synthpod.source_enabled, world, map, SYNTHPOD_PREFIX"sourceEnabled");
 	_register(&regs->synthpod.sink_enabled, world, map, SYNTHPOD_PREFIX"sinkEnabled");
 	_register(&regs->synthpod.learning, world, map, SYNTHPOD_PREFIX"learning");
+	_register(&regs->synthpod.controller_mode, world, map, SYNTHPOD_PREFIX"controllerMode");
+	_register(&regs->synthpod.smoothing, world, map, SYNTHPOD_PREFIX"smoothing");
+	_register(&regs->synthpod.smoothing_time, world, map, SYNTHPOD_PREFIX"smoothingTime");
 
 	_register(&regs->synthpod.placeholder, world, map, SYNTHPOD_PREFIX"placeholder");
 	_register(&regs->synthpod.visibility, world, map, SYNTHPOD_PREFIX"visibility");
@@ -918,6 +950,7 @@ sp_regs_deinit(reg_t *regs)
 	_unregister(&regs->synthpod.module_position_x);
 	_unregister(&regs->synthpod.module_position_y);
 	_unregister(&regs->synthpod.module_alias);
+	_unregister(&regs->synthpod.module_tail);
 	_unregister(&regs->synthpod.module_reinstantiate);
 	_unregister(&regs->synthpod.module_created);
 	_unregister(&regs->synthpod.node_position_x);
@@ -964,6 +997,9 @@ sp_regs_deinit(reg_t *regs)
 	_unregister(&regs->synthpod.source_enabled);
 	_unregister(&regs->synthpod.sink_enabled);
 	_unregister(&regs->synthpod.learning);
+	_unregister(&regs->synthpod.controller_mode);
+	_unregister(&regs->synthpod.smoothing);
+	_unregister(&regs->synthpod.smoothing_time);
 
 	_unregister(&regs->synthpod.placeholder);
 	_unregister(&regs->synthpod.visibility);
@@ -175,6 +175,7 @@ struct _midi_auto_t {
 	int b;
 	int channel;
 	int controller;
+	int mode;
 };
 
 struct _osc_auto_t {
@@ -193,6 +194,9 @@ struct _auto_t {
 
 	int learning;
 
+	int smoothing;
+	double smoothing_time;
+
 	union {
 		midi_auto_t midi;
 		osc_auto_t osc;
@@ -305,6 +309,7 @@ struct _mod_t {
 		struct nk_image img;
 	} idisp;
 	char alias [ALIAS_MAX];
+	float tail; // silence tail in seconds, 0 to never idle
 
 #if defined(USE_CAIRO_CANVAS)
 	struct {
@@ -592,6 +597,18 @@ static const char *auto_labels [] = {
 	[AUTO_OSC] = "OSC"
 };
 
+static const char *auto_midi_mode_labels [] = {
+	[AUTO_MIDI_MODE_CC7] = "7-bit CC",
+	[AUTO_MIDI_MODE_CC14] = "14-bit CC",
+	[AUTO_MIDI_MODE_NRPN] = "NRPN"
+};
+
+static const char *auto_smoothing_labels [] = {
+	[AUTO_SMOOTHING_NONE] = "No smoothing",
+	[AUTO_SMOOTHING_LINEAR] = "Linear",
+	[AUTO_SMOOTHING_ONE_POLE] = "One-pole"
+};
+
 #if 0
 #	define DBG fprintf(stderr, ":: %s\n", __func__)
 #else
@@ -1460,6 +1477,11 @@ _patch_midi_automation_internal(plughandle_t *handle, auto_t *automation)
 	if(ref)
 		ref = lv2_atom_forge_int(&handle->forge, automation->midi.controller);
 
+	if(ref)
+		ref = lv2_atom_forge_key(&handle->forge, handle->regs.synthpod.controller_mode.urid);
+	if(ref)
+		ref = lv2_atom_forge_int(&handle->forge, automation->midi.mode);
+
 	if(ref)
 		ref = lv2_atom_forge_key(&handle->forge, handle->regs.synthpod.source_min.urid);
 	if(ref)
@@ -1495,6 +1517,16 @@ _patch_midi_automation_internal(plughandle_t *handle, auto_t *automation)
 	if(ref)
 		ref = lv2_atom_forge_bool(&handle->forge, automation->learning);
 
+	if(ref)
+		ref = lv2_atom_forge_key(&handle->forge, handle->regs.synthpod.smoothing.urid);
+	if(ref)
+		ref = lv2_atom_forge_int(&handle->forge, automation->smoothing);
+
+	if(ref)
+		ref = lv2_atom_forge_key(&handle->forge, handle->regs.synthpod.smoothing_time.urid);
+	if(ref)
+		ref = lv2_atom_forge_double(&handle->forge, automation->smoothing_time);
+
 	return ref;
 }
 
@@ -1541,6 +1573,16 @@ _patch_osc_automation_internal(plughandle_t *handle, auto_t *automation)
 	if(ref)
 		ref = lv2_atom_forge_bool(&handle->forge, automation->learning);
 
+	if(ref)
+		ref = lv2_atom_forge_key(&handle->forge, handle->regs.synthpod.smoothing.urid);
+	if(ref)
+		ref = lv2_atom_forge_int(&handle->forge, automation->smoothing);
+
+	if(ref)
+		ref = lv2_atom_forge_key(&handle->forge, handle->regs.synthpod.smoothing_time.urid);
+	if(ref)
+		ref = lv2_atom_forge_double(&handle->forge, automation->smoothing_time);
+
 	return ref;
 }
 
@@ -7446,6 +7488,21 @@ _osc_path_filter(const struct nk_text_edit *box, nk_rune unicode)
 	return nk_true;
 }
 
+static inline void
+_automation_smoothing_widget(struct nk_context *ctx, auto_t *automation, float dy)
+{
+	DBG;
+	automation->smoothing = nk_combo(ctx, auto_smoothing_labels, AUTO_SMOOTHING_NUM,
+		automation->smoothing, dy, nk_vec2(nk_widget_width(ctx), dy*5));
+
+	if(automation->smoothing != AUTO_SMOOTHING_NONE)
+	{
+		double ms = automation->smoothing_time * 1e3;
+		nk_property_double(ctx, "Smoothing (ms)", 0.0, &ms, 10000.0, 1.0, 1.f);
+		automation->smoothing_time = ms * 1e-3;
+	}
+}
+
 static inline void
 _control_randomize(plughandle_t *handle, mod_t *mod, control_port_t *control)
 {
@@ -7856,6 +7913,7 @@ _expose_main_body(plughandle_t *handle, struct nk_context *ctx, float dh, float
 									// initialize
 									automation->midi.channel = -1;
 									automation->midi.controller = -1;
+									automation->midi.mode = AUTO_MIDI_MODE_CC7;
 									automation->midi.a = 0x0;
 									automation->midi.b = 0x7f;
 									automation->c = c;
@@ -7924,13 +7982,33 @@ _expose_main_body(plughandle_t *handle, struct nk_context *ctx, float dh, float
 								nk_label(ctx, "Output", NK_TEXT_LEFT);
 
 							nk_layout_row_dynamic(ctx, dy, 1);
+							const int mode = automation->midi.mode;
+							automation->midi.mode = nk_combo(ctx, auto_midi_mode_labels, AUTO_MIDI_MODE_NUM,
+								automation->midi.mode, dy, nk_vec2(nk_widget_width(ctx), dy*5));
+							const int max_val = (automation->midi.mode == AUTO_MIDI_MODE_CC7)
+								? 0x7f
+								: 0x3fff;
+							if(mode != automation->midi.mode)
+							{
+								// reset controller and source range when switching resolution
+								automation->midi.controller = -1;
+								automation->midi.a = 0x0;
+								automation->midi.b = max_val;
+							}
+							const int max_controller = (automation->midi.mode == AUTO_MIDI_MODE_CC14)
+								? 0x1f
+								: max_val;
+
 							nk_property_int(ctx, "MIDI Channel", -1, &automation->midi.channel, 0xf, 1, ipp);
-							nk_property_int(ctx, "MIDI Controller", -1, &automation->midi.controller, 0x7f, 1, ipp);
-							nk_property_int(ctx, "MIDI Minimum", 0, &automation->midi.a, 0x7f, 1, ipp);
-							nk_property_int(ctx, "MIDI Maximum", 0, &automation->midi.b, 0x7f, 1, ipp);
+							nk_property_int(ctx,
+								automation->midi.mode == AUTO_MIDI_MODE_NRPN ? "MIDI NRPN" : "MIDI Controller",
+								-1, &automation->midi.controller, max_controller, 1, ipp);
+							nk_property_int(ctx, "MIDI Minimum", 0, &automation->midi.a, max_val, 1, ipp);
+							nk_property_int(ctx, "MIDI Maximum", 0, &automation->midi.b, max_val, 1, ipp);
 							nk_spacing(ctx, 1);
 							nk_property_double(ctx, "Target Minimum", c, &automation->c, d, inc, ipp);
 							nk_property_double(ctx, "Target Maximum", c, &automation->d, d, inc, ipp);
+							_automation_smoothing_widget(ctx, automation, dy);
 						}
 						else if(automation->type == AUTO_OSC)
 						{
@@ -7960,6 +8038,7 @@ _expose_main_body(plughandle_t *handle, struct nk_context *ctx, float dh, float
 							nk_spacing(ctx, 1);
 							nk_property_double(ctx, "Target Minimum", c, &automation->c, d, inc, ipp);
 							nk_property_double(ctx, "Target Maximum", c, &automation->d, d, inc, ipp);
+							_automation_smoothing_widget(ctx, automation, dy);
 						}
 
 						if(memcmp(&old_auto, automation, sizeof(auto_t))) // needs sync
@@ -8048,6 +8127,23 @@ _expose_main_body(plughandle_t *handle, struct nk_context *ctx, float dh, float
 						//FIXME implement select-all
 					}
 
+					{
+						nk_layout_row_dynamic(ctx, dy, 1);
+
+						const float old_tail = mod->tail;
+						nk_property_float(ctx, "#Silence tail [s]", 0.f, &mod->tail, 60.f, 0.1f, 0.01f);
+						if(old_tail != mod->tail)
+						{
+							if(  _message_request(handle)
+								&& synthpod_patcher_set(&handle->regs, &handle->forge,
+									mod->urn, 0, handle->regs.synthpod.module_tail.urid,
+									sizeof(float), handle->forge.Float, &mod->tail) )
+							{
+								_message_write(handle);
+							}
+						}
+					}
+
 					const unsigned nuis = _hash_size(&mod->uis);
 					if(nuis)
 					{
@@ -8829,6 +8925,9 @@ _add_automation(plughandle_t *handle, const LV2_Atom_Object *obj)
 	const LV2_Atom_Double *snk_max = NULL;
 	const LV2_Atom_Bool *src_enabled = NULL;
 	const LV2_Atom_Bool *snk_enabled = NULL;
+	const LV2_Atom_Int *midi_mode = NULL;
+	const LV2_Atom_Int *smoothing = NULL;
+	const LV2_Atom_Double *smoothing_time = NULL;
 
 	lv2_atom_object_get(obj,
 		handle->regs.synthpod.sink_module.urid, &src_module,
@@ -8843,6 +8942,9 @@ _add_automation(plughandle_t *handle, const LV2_Atom_Object *obj)
 		handle->regs.synthpod.sink_max.urid, &snk_max,
 		handle->regs.synthpod.source_enabled.urid, &src_enabled,
 		handle->regs.synthpod.sink_enabled.urid, &snk_enabled,
+		handle->regs.synthpod.controller_mode.urid, &midi_mode,
+		handle->regs.synthpod.smoothing.urid, &smoothing,
+		handle->regs.synthpod.smoothing_time.urid, &smoothing_time,
 		0);
 
 	const LV2_URID src_urn = src_module
@@ -8892,6 +8994,8 @@ _add_automation(plughandle_t *handle, const LV2_Atom_Object *obj)
 	automation->snk_enabled= snk_enabled ? snk_enabled->body : false;
 	automation->c = snk_min ? snk_min->body : 0.0; //FIXME
 	automation->d = snk_max ? snk_max->body : 0.0; //FIXME
+	automation->smoothing = smoothing ? smoothing->body : AUTO_SMOOTHING_NONE;
+	automation->smoothing_time = smoothing_time ? smoothing_time->body : 0.0;
 
 	if(obj->body.otype == handle->regs.midi.Controller.urid)
 	{
@@ -8903,6 +9007,7 @@ _add_automation(plughandle_t *handle, const LV2_Atom_Object *obj)
 
 		mauto->channel = midi_channel ? midi_channel->body : -1;
 		mauto->controller = midi_controller ? midi_controller->body : -1;
+		mauto->mode = midi_mode ? midi_mode->body : AUTO_MIDI_MODE_CC7;
 	}
 	else if(obj->body.otype == handle->regs.osc.message.urid)
 	{
@@ -9282,6 +9387,7 @@ port_event(LV2UI_Handle instance, uint32_t port_index, uint32_t size,
 						const LV2_Atom_Float *mod_pos_x = NULL;
 						const LV2_Atom_Float *mod_pos_y = NULL;
 						const LV2_Atom_String *mod_alias = NULL;
+						const LV2_Atom_Float *mod_tail = NULL;
 						const LV2_Atom_URID *ui_uri = NULL;
 						const LV2_Atom_Long *instance_access = NULL;
 
@@ -9290,6 +9396,7 @@ port_event(LV2UI_Handle instance, uint32_t port_index, uint32_t size,
 							handle->regs.synthpod.module_position_x.urid, &mod_pos_x,
 							handle->regs.synthpod.module_position_y.urid, &mod_pos_y,
 							handle->regs.synthpod.module_alias.urid, &mod_alias,
+							handle->regs.synthpod.module_tail.urid, &mod_tail,
 							handle->regs.ui.ui.urid, &ui_uri, //FIXME use this
 							handle->regs.ui.instance_access.urid, &instance_access,
 							0); //FIXME query more
@@ -9354,6 +9461,11 @@ port_event(LV2UI_Handle instance, uint32_t port_index, uint32_t size,
 								strncpy(mod->alias, LV2_ATOM_BODY_CONST(&mod_alias->atom), ALIAS_MAX-1);
 							}
 
+							if(mod_tail && (mod_tail->atom.type == handle->forge.Float) )
+							{
+								mod->tail = mod_tail->body;
+							}
+
 							if(instance_access && (instance_access->atom.type == handle->forge.Long) )
 							{
 								mod->dsp_instance = (LilvInstance *)instance_access->body;